@@ -0,0 +1,81 @@
+# Core of the library shared by GUI (rcs-xn.pro) and headless (rcs-xn-core.pro) build
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+	$$PWD/src/rcs-xn.cpp \
+	$$PWD/src/rcsinputmodule.cpp \
+	$$PWD/src/fall-timer-wheel.cpp \
+	$$PWD/src/log-sink.cpp \
+	$$PWD/src/output-queue.cpp \
+	$$PWD/src/ini-data.cpp \
+	$$PWD/src/settings.cpp \
+	$$PWD/src/signals.cpp \
+	$$PWD/src/snapshot.cpp \
+	$$PWD/src/xn-thread.cpp \
+	$$PWD/src/lib-api.cpp
+HEADERS += \
+	$$PWD/src/bit-array.h \
+	$$PWD/src/common.h \
+	$$PWD/src/rcs-xn.h \
+	$$PWD/src/rcs-xn-observer.h \
+	$$PWD/src/errors.h \
+	$$PWD/src/events.h \
+	$$PWD/src/io-state.h \
+	$$PWD/src/rcsinputmodule.h \
+	$$PWD/src/fall-timer-wheel.h \
+	$$PWD/src/log-sink.h \
+	$$PWD/src/output-queue.h \
+	$$PWD/src/ini-data.h \
+	$$PWD/src/settings.h \
+	$$PWD/src/util.h \
+	$$PWD/src/signals.h \
+	$$PWD/src/snapshot.h \
+	$$PWD/src/xn-thread.h \
+	$$PWD/src/lib-api.h \
+	$$PWD/src/lib-api-common-def.h \
+	$$PWD/src/range-codec.h
+
+SOURCES += \
+	$$PWD/lib/xn-lib-cpp-qt/xn-pending.cpp \
+	$$PWD/lib/xn-lib-cpp-qt/xn.cpp \
+	$$PWD/lib/xn-lib-cpp-qt/xn-api.cpp \
+	$$PWD/lib/xn-lib-cpp-qt/xn-receive.cpp \
+	$$PWD/lib/xn-lib-cpp-qt/xn-send.cpp \
+	$$PWD/lib/xn-lib-cpp-qt/xn-win-com-discover.cpp
+HEADERS += \
+	$$PWD/lib/xn-lib-cpp-qt/q-str-exception.h \
+	$$PWD/lib/xn-lib-cpp-qt/xn-loco-addr.h \
+	$$PWD/lib/xn-lib-cpp-qt/xn-commands.h \
+	$$PWD/lib/xn-lib-cpp-qt/xn.h \
+	$$PWD/lib/q-str-exception.h \
+	$$PWD/lib/xn-lib-cpp-qt/xn-win-com-discover.h
+
+CONFIG += c++14 dll
+QMAKE_CXXFLAGS += -Wall -Wextra -pedantic
+
+win32 {
+	QMAKE_LFLAGS += -Wl,--kill-at
+	QMAKE_CXXFLAGS += -enable-stdcall-fixup
+	LIBS += -lsetupapi
+}
+win64 {
+	QMAKE_LFLAGS += -Wl,--kill-at
+	QMAKE_CXXFLAGS += -enable-stdcall-fixup
+	LIBS += -lsetupapi
+}
+
+QT += core serialport
+
+VERSION_MAJOR = 2
+VERSION_MINOR = 0
+
+DEFINES += "VERSION_MAJOR=$$VERSION_MAJOR" \
+	"VERSION_MINOR=$$VERSION_MINOR" \
+
+# Uncomment for official release without '-dev' in caption
+# DEFINES += "RCS_XN_RELEASE"
+
+#Target version
+VERSION = "$${VERSION_MAJOR}.$${VERSION_MINOR}"
+DEFINES += "VERSION=\\\"$${VERSION}\\\""
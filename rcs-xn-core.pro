@@ -0,0 +1,10 @@
+# Headless build of the library: no configuration dialog, QCoreApplication only.
+# Configuration is done only via config file (LoadConfig) & API.
+
+TARGET = rcs-xn-core
+TEMPLATE = lib
+
+include(rcs-xn-core.pri)
+
+DEFINES += RCS_XN_HEADLESS
+QT -= gui
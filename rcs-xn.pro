@@ -1,29 +1,20 @@
 TARGET = rcs-xn
 TEMPLATE = lib
-DEFINES += QT_DEPRECATED_WARNINGS
+
+include(rcs-xn-core.pri)
 
 SOURCES += \
 	src/form-in-module-edit.cpp \
-	src/rcs-xn.cpp \
 	src/rcs-xn-gui.cpp \
-	src/rcsinputmodule.cpp \
-	src/settings.cpp \
-	src/signals.cpp \
-	src/form-signal-edit.cpp \
-	src/lib-api.cpp
+	src/input-modules-model.cpp \
+	src/log-model.cpp \
+	src/form-signal-edit.cpp
 HEADERS += \
-	src/common.h \
 	src/form-in-module-edit.h \
-	src/rcs-xn.h \
-	src/errors.h \
-	src/events.h \
-	src/rcsinputmodule.h \
-	src/settings.h \
-	src/util.h \
-	src/signals.h \
+	src/rcs-xn-gui.h \
+	src/input-modules-model.h \
+	src/log-model.h \
 	src/form-signal-edit.h \
-	src/lib-api.h \
-	src/lib-api-common-def.h \
 	src/q-tree-num-widget-item.h
 
 FORMS += \
@@ -31,47 +22,5 @@ FORMS += \
 	form/signal-edit.ui \
 	form/input-module-edit.ui
 
-SOURCES += \
-	lib/xn-lib-cpp-qt/xn-pending.cpp \
-	lib/xn-lib-cpp-qt/xn.cpp \
-	lib/xn-lib-cpp-qt/xn-api.cpp \
-	lib/xn-lib-cpp-qt/xn-receive.cpp \
-	lib/xn-lib-cpp-qt/xn-send.cpp \
-	lib/xn-lib-cpp-qt/xn-win-com-discover.cpp
-HEADERS += \
-	lib/xn-lib-cpp-qt/q-str-exception.h \
-	lib/xn-lib-cpp-qt/xn-loco-addr.h \
-	lib/xn-lib-cpp-qt/xn-commands.h \
-	lib/xn-lib-cpp-qt/xn.h \
-	lib/q-str-exception.h \
-	lib/xn-lib-cpp-qt/xn-win-com-discover.h
-
-CONFIG += c++14 dll
-QMAKE_CXXFLAGS += -Wall -Wextra -pedantic
-
-win32 {
-	QMAKE_LFLAGS += -Wl,--kill-at
-	QMAKE_CXXFLAGS += -enable-stdcall-fixup
-	LIBS += -lsetupapi
-}
-win64 {
-	QMAKE_LFLAGS += -Wl,--kill-at
-	QMAKE_CXXFLAGS += -enable-stdcall-fixup
-	LIBS += -lsetupapi
-}
-
-QT += core gui serialport
+QT += gui
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-VERSION_MAJOR = 2
-VERSION_MINOR = 0
-
-DEFINES += "VERSION_MAJOR=$$VERSION_MAJOR" \
-	"VERSION_MINOR=$$VERSION_MINOR" \
-
-# Uncomment for official release without '-dev' in caption
-# DEFINES += "RCS_XN_RELEASE"
-
-#Target version
-VERSION = "$${VERSION_MAJOR}.$${VERSION_MINOR}"
-DEFINES += "VERSION=\\\"$${VERSION}\\\""
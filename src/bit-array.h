@@ -0,0 +1,83 @@
+#ifndef BIT_ARRAY_H
+#define BIT_ARRAY_H
+
+/* Fixed-size bit array stored in 64-bit words aligned to a cache line.
+ * Counting, clearing and searching for runs of bits work on whole words
+ * instead of iterating single bits.
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace RcsXn {
+
+template <std::size_t N>
+class alignas(64) BitArray {
+public:
+	static constexpr std::size_t WORDS = (N + 63) / 64;
+
+	constexpr std::size_t size() const { return N; }
+
+	bool operator[](std::size_t i) const { return (this->m_words[i / 64] >> (i % 64)) & 1; }
+
+	void set(std::size_t i, bool value = true) {
+		if (value)
+			this->m_words[i / 64] |= (uint64_t{1} << (i % 64));
+		else
+			this->m_words[i / 64] &= ~(uint64_t{1} << (i % 64));
+	}
+
+	void setRange(std::size_t first, std::size_t last) { // including last
+		for (std::size_t word = first / 64; word <= last / 64; word++) {
+			uint64_t mask = ~uint64_t{0};
+			if (word == first / 64)
+				mask &= ~uint64_t{0} << (first % 64);
+			if (word == last / 64)
+				mask &= ~uint64_t{0} >> (63 - last % 64);
+			this->m_words[word] |= mask;
+		}
+	}
+
+	void reset() { this->m_words.fill(0); }
+
+	std::size_t count() const {
+		std::size_t result = 0;
+		for (uint64_t word : this->m_words)
+			result += static_cast<std::size_t>(__builtin_popcountll(word));
+		return result;
+	}
+
+	// Index of first bit with 'value' at position >= from, N if there is none
+	std::size_t findNext(bool value, std::size_t from) const {
+		if (from >= N)
+			return N;
+		std::size_t word = from / 64;
+		uint64_t bits = (value ? this->m_words[word] : ~this->m_words[word]) &
+		                (~uint64_t{0} << (from % 64));
+		while (bits == 0) {
+			if (++word >= WORDS)
+				return N;
+			bits = (value) ? this->m_words[word] : ~this->m_words[word];
+		}
+		const std::size_t result = word*64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+		return (result < N) ? result : N;
+	}
+
+	uint64_t word(std::size_t i) const { return this->m_words[i]; }
+	void setWord(std::size_t i, uint64_t word) { this->m_words[i] = word; }
+
+	BitArray operator|(const BitArray &other) const {
+		BitArray result;
+		for (std::size_t i = 0; i < WORDS; i++)
+			result.m_words[i] = this->m_words[i] | other.m_words[i];
+		return result;
+	}
+
+private:
+	std::array<uint64_t, WORDS> m_words {};
+};
+
+} // namespace RcsXn
+
+#endif // BIT_ARRAY_H
@@ -2,7 +2,7 @@
 #define COMMON_H
 
 #include <cstddef>
-#include <QColor>
+#include <cstdint>
 
 namespace RcsXn {
 
@@ -11,21 +11,29 @@ constexpr size_t IO_OUT_MODULE_PIN_COUNT = 2;
 constexpr size_t IO_IN_MODULE_PIN_COUNT = 8;
 constexpr size_t IO_OUT_MODULES_COUNT = IO_COUNT / IO_OUT_MODULE_PIN_COUNT;
 constexpr size_t IO_IN_MODULES_COUNT = IO_COUNT / IO_IN_MODULE_PIN_COUNT;
-constexpr size_t SIGNAL_INIT_RESET_PERIOD = 200; // ms
+constexpr size_t SIGNAL_RESET_MAX_PENDING = 8; // pending output commands during signals reset
 constexpr size_t OUTPUT_ACTIVE_TIME = 500; // ms
-constexpr size_t ACC_RESET_TIMER_PERIOD = 100; // ms
-
-const QColor LOGC_ERROR = QColor(0xFF, 0xAA, 0xAA);
-const QColor LOGC_WARN = QColor(0xFF, 0xFF, 0xAA);
-const QColor LOGC_DONE = QColor(0xAA, 0xFF, 0xAA);
-const QColor LOGC_GET = QColor(0xE0, 0xE0, 0xFF);
-const QColor LOGC_PUT = QColor(0xE0, 0xFF, 0xE0);
-
-enum class XnInState {
-	unknown,
-	off,
-	on,
-	falling,
+constexpr size_t SCAN_DEFAULT_WINDOW = 4; // groups scanned in parallel
+constexpr size_t SCAN_MAX_RETRIES = 2;
+constexpr size_t CONFIG_SAVE_DELAY = 1000; // ms; GUI edits are saved together after this delay
+constexpr size_t SNAPSHOT_PERIOD = 10000; // ms; I/O state snapshot for warm restart
+constexpr size_t GUI_REFRESH_PERIOD = 66; // ms; changed rows of input modules table (~15 Hz)
+
+enum class RcsXnLogLevel {
+	llNo = 0,
+	llError = 1,
+	llWarning = 2,
+	llInfo = 3,
+	llCommands = 4,
+	llRawCommands = 5,
+	llDebug = 6,
+};
+
+enum class XnInState : uint8_t { // 2 bits, see InStates
+	unknown = 0,
+	off = 1,
+	on = 2,
+	falling = 3,
 };
 
 inline XnInState xnInState(bool state) {
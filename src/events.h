@@ -1,13 +1,35 @@
 #ifndef EVENTS_H
 #define EVENTS_H
 
+#include <QMutex>
+#include <QObject>
 #include <QString>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "lib-api-common-def.h"
 
 /* This file provides storage & calling capabilities of callbacks from the
  * library back to the hJOPserver.
+ *
+ * Each event has one slot set by Bind* functions (hJOPserver) and any number
+ * of subscribers (Subscribe* functions, e.g. monitoring tools). Subscriber
+ * receives only events in its event mask; module events only for modules in
+ * its module range. Subscriber is called after the bound slot.
+ *
+ * Threading contract: events raised in XN thread are by default delivered
+ * asynchronously (in order they were raised) in the thread which loaded the
+ * library, so the host never runs in XN thread. Host could switch to direct
+ * delivery in XN thread (SetEventsDelivery), e.g. when it does not process
+ * Qt events in its main thread. Log events of asynchronous log sink are always
+ * called in the sink's thread.
  */
 
 namespace RcsXn {
@@ -17,8 +39,17 @@ using StdLogEvent = void CALL_CONV (*)(const void *sender, const void *data, int
                                        const uint16_t *msg);
 using StdErrorEvent = void CALL_CONV (*)(const void *sender, const void *data, uint16_t errValue,
                                          unsigned int errAddr, const uint16_t *errMsg);
+struct RcsLogRecord {
+	int loglevel;
+	const uint16_t *msg;
+};
+
+using StdLogBatchEvent = void CALL_CONV (*)(const void *sender, const void *data,
+                                            const RcsLogRecord *records, unsigned int count);
 using StdModuleChangeEvent = void CALL_CONV (*)(const void *sender, const void *data,
                                                 unsigned int module);
+using StdProgressEvent = void CALL_CONV (*)(const void *sender, const void *data,
+                                            unsigned int done, unsigned int total);
 
 template <typename F>
 struct EventData {
@@ -27,41 +58,125 @@ struct EventData {
 	bool defined() const { return this->func != nullptr; }
 };
 
+// Bit n of event mask = event type n (values are part of Subscribe* API)
+enum class RcsEventType : unsigned int {
+	beforeOpen = 0,
+	afterOpen = 1,
+	beforeClose = 2,
+	afterClose = 3,
+	beforeStart = 4,
+	afterStart = 5,
+	beforeStop = 6,
+	afterStop = 7,
+	onScanned = 8,
+	onError = 9,
+	onInputChanged = 10,
+	onOutputChanged = 11,
+	onModuleChanged = 12,
+	onSignalsResetProgress = 13,
+};
+
+constexpr uint32_t eventMask(RcsEventType type) {
+	return uint32_t{1} << static_cast<unsigned int>(type);
+}
+
+constexpr uint32_t EVENTS_NOTIFY_MASK = 0x01FF; // beforeOpen .. onScanned
+constexpr uint32_t EVENTS_MODULE_MASK = 0x1C00; // onInputChanged .. onModuleChanged
+
+// Event which could have subscribers
+template <typename F>
+struct Event : EventData<F> {
+	explicit Event(RcsEventType type) : type(type) {}
+	const RcsEventType type;
+};
+
+struct EventSubscriber {
+	using Callback = void (*)(); // real type is given by event mask, see RcsEvents::subscribe
+
+	unsigned int id = 0;
+	uint32_t mask = 0;
+	unsigned int firstModule = 0, lastModule = 0; // module events only
+	Callback callback = nullptr;
+	void *data = nullptr;
+	std::atomic<bool> active {true}; // false = unsubscribed, events already posted are skipped
+	std::recursive_mutex calling; // held while callback runs, unsubscribe waits for it
+
+	bool matches(RcsEventType type, unsigned int module) const {
+		if (!(this->mask & eventMask(type)))
+			return false;
+		if (eventMask(type) & EVENTS_MODULE_MASK)
+			return (module >= this->firstModule) && (module <= this->lastModule);
+		return true;
+	}
+};
+
 struct RcsEvents {
-	EventData<StdNotifyEvent> beforeOpen;
-	EventData<StdNotifyEvent> afterOpen;
-	EventData<StdNotifyEvent> beforeClose;
-	EventData<StdNotifyEvent> afterClose;
+	Event<StdNotifyEvent> beforeOpen {RcsEventType::beforeOpen};
+	Event<StdNotifyEvent> afterOpen {RcsEventType::afterOpen};
+	Event<StdNotifyEvent> beforeClose {RcsEventType::beforeClose};
+	Event<StdNotifyEvent> afterClose {RcsEventType::afterClose};
 
-	EventData<StdNotifyEvent> beforeStart;
-	EventData<StdNotifyEvent> afterStart;
-	EventData<StdNotifyEvent> beforeStop;
-	EventData<StdNotifyEvent> afterStop;
+	Event<StdNotifyEvent> beforeStart {RcsEventType::beforeStart};
+	Event<StdNotifyEvent> afterStart {RcsEventType::afterStart};
+	Event<StdNotifyEvent> beforeStop {RcsEventType::beforeStop};
+	Event<StdNotifyEvent> afterStop {RcsEventType::afterStop};
 
-	EventData<StdNotifyEvent> onScanned;
-	EventData<StdErrorEvent> onError;
-	EventData<StdLogEvent> onLog;
+	Event<StdNotifyEvent> onScanned {RcsEventType::onScanned};
+	Event<StdErrorEvent> onError {RcsEventType::onError};
+	EventData<StdLogEvent> onLog; // log has no subscribers (see SetHostLogLevel)
+	EventData<StdLogBatchEvent> onLogBatch;
 
-	EventData<StdModuleChangeEvent> onInputChanged;
-	EventData<StdModuleChangeEvent> onOutputChanged;
-	EventData<StdModuleChangeEvent> onModuleChanged;
+	Event<StdModuleChangeEvent> onInputChanged {RcsEventType::onInputChanged};
+	Event<StdModuleChangeEvent> onOutputChanged {RcsEventType::onOutputChanged};
+	Event<StdModuleChangeEvent> onModuleChanged {RcsEventType::onModuleChanged};
 
-	void call(const EventData<StdNotifyEvent> &e) const {
-		if (e.defined())
-			e.func(this, e.data);
+	Event<StdProgressEvent> onSignalsResetProgress {RcsEventType::onSignalsResetProgress};
+
+	// Events raised in xnThread are posted to thread of hostContext (nullptr = direct)
+	QObject *hostContext = nullptr;
+	const QThread *xnThread = nullptr;
+	bool directDelivery = false;
+
+	template <typename F>
+	void deliver(F &&f) const {
+		if ((this->hostContext != nullptr) && (!this->directDelivery) &&
+		    (QThread::currentThread() == this->xnThread))
+			QMetaObject::invokeMethod(this->hostContext, std::forward<F>(f), Qt::QueuedConnection);
+		else
+			f();
 	}
-	void call(const EventData<StdErrorEvent> &e, uint16_t errValue, unsigned int errAddr,
+
+	void call(const Event<StdNotifyEvent> &e) const {
+		this->dispatch(e, 0, [this](StdNotifyEvent func, void *data) { func(this, data); });
+	}
+	void call(const Event<StdErrorEvent> &e, uint16_t errValue, unsigned int errAddr,
 	          const QString &errMsg) const {
-		if (e.defined())
-			e.func(this, e.data, errValue, errAddr, errMsg.utf16());
+		this->dispatch(e, errAddr,
+		               [this, errValue, errAddr, errMsg](StdErrorEvent func, void *data) {
+			               func(this, data, errValue, errAddr, errMsg.utf16());
+		               });
 	}
 	void call(const EventData<StdLogEvent> &e, int loglevel, const QString &msg) const {
 		if (e.defined())
-			e.func(this, e.data, loglevel, msg.utf16());
+			this->deliver([this, e, loglevel, msg]() {
+				e.func(this, e.data, loglevel, msg.utf16());
+			});
 	}
-	void call(const EventData<StdModuleChangeEvent> &e, unsigned int module) const {
+	void call(const EventData<StdLogBatchEvent> &e, const RcsLogRecord *records,
+	          unsigned int count) const {
+		// Records are owned by caller -> always direct, see RcsXn::hostLog
 		if (e.defined())
-			e.func(this, e.data, module);
+			e.func(this, e.data, records, count);
+	}
+	void call(const Event<StdModuleChangeEvent> &e, unsigned int module) const {
+		this->dispatch(e, module, [this, module](StdModuleChangeEvent func, void *data) {
+			func(this, data, module);
+		});
+	}
+	void call(const Event<StdProgressEvent> &e, size_t done, size_t total) const {
+		this->dispatch(e, 0, [this, done, total](StdProgressEvent func, void *data) {
+			func(this, data, static_cast<unsigned int>(done), static_cast<unsigned int>(total));
+		});
 	}
 
 	template <typename F>
@@ -69,6 +184,90 @@ struct RcsEvents {
 		event.func = func;
 		event.data = data;
 	}
+
+	// Returns subscription handle (> 0). Type of callback must correspond to event mask
+	// (validated by Subscribe* API functions).
+	template <typename F>
+	unsigned int subscribe(uint32_t mask, unsigned int firstModule, unsigned int lastModule,
+	                       F func, void *data) {
+		auto subscriber = std::make_shared<EventSubscriber>();
+		subscriber->mask = mask;
+		subscriber->firstModule = firstModule;
+		subscriber->lastModule = lastModule;
+		subscriber->callback = reinterpret_cast<EventSubscriber::Callback>(func);
+		subscriber->data = data;
+
+		QMutexLocker locker(&this->m_subscribers_lock);
+		subscriber->id = ++this->m_last_subscription_id;
+		this->m_subscribers.push_back(subscriber);
+		this->m_subscribed_mask |= mask;
+		return subscriber->id;
+	}
+
+	// Could be called from any thread; waits for callback of the subscriber running in other
+	// thread, so no callback runs after return (unsubscribing from the callback itself is fine).
+	bool unsubscribe(unsigned int id) {
+		std::shared_ptr<EventSubscriber> unsubscribed;
+		{
+			QMutexLocker locker(&this->m_subscribers_lock);
+			const auto it = std::find_if(
+				this->m_subscribers.begin(), this->m_subscribers.end(),
+				[id](const std::shared_ptr<EventSubscriber> &s) { return s->id == id; }
+			);
+			if (it == this->m_subscribers.end())
+				return false;
+			unsubscribed = *it;
+			unsubscribed->active = false;
+			this->m_subscribers.erase(it);
+
+			uint32_t mask = 0;
+			for (const auto &subscriber : this->m_subscribers)
+				mask |= subscriber->mask;
+			this->m_subscribed_mask = mask;
+		}
+
+		std::lock_guard<std::recursive_mutex> calling(unsubscribed->calling);
+		return true;
+	}
+
+private:
+	mutable QMutex m_subscribers_lock;
+	std::vector<std::shared_ptr<EventSubscriber>> m_subscribers;
+	unsigned int m_last_subscription_id = 0;
+	std::atomic<uint32_t> m_subscribed_mask {0}; // fast check without locking
+
+	std::vector<std::shared_ptr<EventSubscriber>> subscribers(RcsEventType type,
+	                                                          unsigned int module) const {
+		std::vector<std::shared_ptr<EventSubscriber>> result;
+		QMutexLocker locker(&this->m_subscribers_lock);
+		for (const auto &subscriber : this->m_subscribers)
+			if (subscriber->matches(type, module))
+				result.push_back(subscriber);
+		return result;
+	}
+
+	// Subscribers are evaluated at delivery time and called under their calling lock,
+	// so no subscriber is called after unsubscribe returns in any thread.
+	template <typename F, typename Invoke>
+	void dispatch(const Event<F> &e, unsigned int module, Invoke invoke) const {
+		const EventData<F> bound = e;
+		const RcsEventType type = e.type;
+		const bool subscribed = (this->m_subscribed_mask & eventMask(type));
+		if ((!bound.defined()) && (!subscribed))
+			return;
+
+		this->deliver([this, bound, type, module, subscribed, invoke]() {
+			if (bound.defined())
+				invoke(bound.func, bound.data);
+			if (!subscribed)
+				return;
+			for (const auto &subscriber : this->subscribers(type, module)) {
+				std::lock_guard<std::recursive_mutex> calling(subscriber->calling);
+				if (subscriber->active)
+					invoke(reinterpret_cast<F>(subscriber->callback), subscriber->data);
+			}
+		});
+	}
 };
 
 } // namespace RcsXn
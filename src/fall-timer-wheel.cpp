@@ -0,0 +1,101 @@
+#include "fall-timer-wheel.h"
+
+namespace RcsXn {
+
+constexpr uint16_t FallTimerWheel::NONE;
+
+FallTimerWheel::FallTimerWheel(Callback callback) : m_callback(std::move(callback)) {
+	m_slots.fill(NONE);
+	m_expired.reserve(IO_COUNT);
+	m_timer.setInterval(FALL_WHEEL_TICK);
+	QObject::connect(&m_timer, &QTimer::timeout, [this]() { this->tick(); });
+}
+
+uint16_t FallTimerWheel::pinIndex(unsigned module, unsigned port) {
+	return static_cast<uint16_t>(module*IO_IN_MODULE_PIN_COUNT + port);
+}
+
+void FallTimerWheel::arm(unsigned module, unsigned port, unsigned ticks) {
+	if ((module >= IO_IN_MODULES_COUNT) || (port >= IO_IN_MODULE_PIN_COUNT))
+		return;
+	const uint16_t pin = pinIndex(module, port);
+	if (m_nodes[pin].slot != NONE)
+		this->unlink(pin);
+	// Current tick is partially elapsed already -> one more tick, fall is never early
+	ticks++;
+
+	// Slot is visited (ticks-1)/SLOTS times before the one it expires in
+	const uint16_t slot = static_cast<uint16_t>((m_cursor + ticks) % FALL_WHEEL_SLOTS);
+	Node &node = m_nodes[pin];
+	node.slot = slot;
+	node.rounds = static_cast<uint16_t>((ticks-1) / FALL_WHEEL_SLOTS);
+	node.prev = NONE;
+	node.next = m_slots[slot];
+	if (node.next != NONE)
+		m_nodes[node.next].prev = pin;
+	m_slots[slot] = pin;
+
+	if (m_armedCount++ == 0)
+		m_timer.start();
+}
+
+void FallTimerWheel::cancel(unsigned module, unsigned port) {
+	if ((module >= IO_IN_MODULES_COUNT) || (port >= IO_IN_MODULE_PIN_COUNT))
+		return;
+	const uint16_t pin = pinIndex(module, port);
+	if (m_nodes[pin].slot != NONE)
+		this->unlink(pin);
+	if (m_armedCount == 0)
+		m_timer.stop();
+}
+
+void FallTimerWheel::cancelAll() {
+	m_nodes.fill(Node());
+	m_slots.fill(NONE);
+	m_armedCount = 0;
+	m_timer.stop();
+}
+
+bool FallTimerWheel::armed(unsigned module, unsigned port) const {
+	if ((module >= IO_IN_MODULES_COUNT) || (port >= IO_IN_MODULE_PIN_COUNT))
+		return false;
+	return m_nodes[pinIndex(module, port)].slot != NONE;
+}
+
+void FallTimerWheel::unlink(uint16_t pin) {
+	Node &node = m_nodes[pin];
+	if (node.prev != NONE)
+		m_nodes[node.prev].next = node.next;
+	else
+		m_slots[node.slot] = node.next;
+	if (node.next != NONE)
+		m_nodes[node.next].prev = node.prev;
+	node = Node();
+	m_armedCount--;
+}
+
+void FallTimerWheel::tick() {
+	m_cursor = (m_cursor + 1) % FALL_WHEEL_SLOTS;
+
+	// Unlink all expired pins first, callbacks could arm or cancel any pin
+	m_expired.clear();
+	uint16_t pin = m_slots[m_cursor];
+	while (pin != NONE) {
+		const uint16_t next = m_nodes[pin].next;
+		if (m_nodes[pin].rounds > 0) {
+			m_nodes[pin].rounds--;
+		} else {
+			this->unlink(pin);
+			m_expired.push_back(pin);
+		}
+		pin = next;
+	}
+
+	if (m_armedCount == 0)
+		m_timer.stop();
+
+	for (uint16_t expired : m_expired)
+		m_callback(expired / IO_IN_MODULE_PIN_COUNT, expired % IO_IN_MODULE_PIN_COUNT);
+}
+
+} // namespace RcsXn
@@ -0,0 +1,59 @@
+#ifndef FALL_TIMER_WHEEL_H
+#define FALL_TIMER_WHEEL_H
+
+/* Timing wheel for delayed falls of inputs. All input pins share a single
+ * QTimer ticking with resolution of inputFallDelays (0.1 s). Arming,
+ * cancelling and expiring a pin is O(1), no Qt timer is registered per pin.
+ */
+
+#include <QTimer>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common.h"
+
+namespace RcsXn {
+
+constexpr size_t FALL_WHEEL_TICK = 100; // ms
+constexpr size_t FALL_WHEEL_SLOTS = 128; // delays up to 12.7 s expire in first round
+
+class FallTimerWheel {
+public:
+	using Callback = std::function<void(unsigned module, unsigned port)>;
+
+	explicit FallTimerWheel(Callback callback);
+
+	// expires after at least ticks*FALL_WHEEL_TICK ms (at most one tick later); rearms if armed
+	void arm(unsigned module, unsigned port, unsigned ticks);
+	void cancel(unsigned module, unsigned port);
+	void cancelAll();
+	bool armed(unsigned module, unsigned port) const;
+
+private:
+	static constexpr uint16_t NONE = 0xFFFF;
+
+	struct Node {
+		uint16_t prev = NONE;
+		uint16_t next = NONE;
+		uint16_t slot = NONE; // NONE = not armed
+		uint16_t rounds = 0; // full wheel turns to wait before expiring
+	};
+
+	std::array<Node, IO_COUNT> m_nodes;
+	std::array<uint16_t, FALL_WHEEL_SLOTS> m_slots; // heads of per-slot lists
+	std::vector<uint16_t> m_expired;
+	unsigned m_cursor = 0;
+	unsigned m_armedCount = 0;
+	QTimer m_timer;
+	Callback m_callback;
+
+	void tick();
+	void unlink(uint16_t pin);
+	static uint16_t pinIndex(unsigned module, unsigned port);
+};
+
+} // namespace RcsXn
+
+#endif // FALL_TIMER_WHEEL_H
@@ -19,14 +19,14 @@ void FormInModuleEdit::accept() {
 
 	this->module->wantActive = this->ui.chb_active->isChecked();
 	this->module->name = this->ui.le_name->text();
-	this->module->inputFallDelays[0] = static_cast<unsigned>(this->ui.dsb_ind1->value()*10);
-	this->module->inputFallDelays[1] = static_cast<unsigned>(this->ui.dsb_ind2->value()*10);
-	this->module->inputFallDelays[2] = static_cast<unsigned>(this->ui.dsb_ind3->value()*10);
-	this->module->inputFallDelays[3] = static_cast<unsigned>(this->ui.dsb_ind4->value()*10);
-	this->module->inputFallDelays[4] = static_cast<unsigned>(this->ui.dsb_ind5->value()*10);
-	this->module->inputFallDelays[5] = static_cast<unsigned>(this->ui.dsb_ind6->value()*10);
-	this->module->inputFallDelays[6] = static_cast<unsigned>(this->ui.dsb_ind7->value()*10);
-	this->module->inputFallDelays[7] = static_cast<unsigned>(this->ui.dsb_ind8->value()*10);
+	this->module->inputFallDelays[0] = static_cast<uint8_t>(this->ui.dsb_ind1->value()*10);
+	this->module->inputFallDelays[1] = static_cast<uint8_t>(this->ui.dsb_ind2->value()*10);
+	this->module->inputFallDelays[2] = static_cast<uint8_t>(this->ui.dsb_ind3->value()*10);
+	this->module->inputFallDelays[3] = static_cast<uint8_t>(this->ui.dsb_ind4->value()*10);
+	this->module->inputFallDelays[4] = static_cast<uint8_t>(this->ui.dsb_ind5->value()*10);
+	this->module->inputFallDelays[5] = static_cast<uint8_t>(this->ui.dsb_ind6->value()*10);
+	this->module->inputFallDelays[6] = static_cast<uint8_t>(this->ui.dsb_ind7->value()*10);
+	this->module->inputFallDelays[7] = static_cast<uint8_t>(this->ui.dsb_ind8->value()*10);
 
 	this->close();
 	emit this->accepted();
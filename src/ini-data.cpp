@@ -0,0 +1,201 @@
+#include <QFile>
+
+#include "ini-data.h"
+#include "lib/q-str-exception.h"
+
+namespace RcsXn {
+
+QVariant IniSection::value(const QString &key, const QVariant &defaultValue) const {
+	const auto it = this->values.find(key);
+	return (it != this->values.end()) ? QVariant(it->second) : defaultValue;
+}
+
+const IniSection &IniData::section(const QString &name) const {
+	static const IniSection empty;
+	const auto it = this->sections.find(name);
+	return (it != this->sections.end()) ? it->second : empty;
+}
+
+IniData IniData::fromFile(const QString &filename, std::vector<IniError> &errors) {
+	IniData data;
+	if (!QFile::exists(filename))
+		return data;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		throw QStrException("Nelze otevřít soubor " + filename);
+	const QString content = QString::fromUtf8(file.readAll());
+
+	const QChar *str = content.constData();
+	const size_t length = static_cast<size_t>(content.size());
+	IniSection *section = &data.sections["General"];
+	unsigned int lineNo = 0;
+	size_t pos = 0;
+
+	while (pos < length) {
+		size_t end = pos;
+		while ((end < length) && (str[end] != QLatin1Char('\n')) && (str[end] != QLatin1Char('\r')))
+			end++;
+		lineNo++;
+		parseLine(str+pos, end-pos, lineNo, section, data, errors);
+
+		pos = end;
+		if ((pos < length) && (str[pos] == QLatin1Char('\r')))
+			pos++;
+		if ((pos < length) && (str[pos] == QLatin1Char('\n')))
+			pos++;
+	}
+
+	return data;
+}
+
+void IniData::parseLine(const QChar *line, size_t length, unsigned int lineNo,
+                        IniSection *&section, IniData &data, std::vector<IniError> &errors) {
+	while ((length > 0) && (line[0].isSpace())) {
+		line++;
+		length--;
+	}
+	while ((length > 0) && (line[length-1].isSpace()))
+		length--;
+
+	if ((length == 0) || (line[0] == QLatin1Char(';')) || (line[0] == QLatin1Char('#')))
+		return;
+
+	if (line[0] == QLatin1Char('[')) {
+		if (line[length-1] != QLatin1Char(']')) {
+			errors.push_back({lineNo, "Missing ']'"});
+			return;
+		}
+		section = &data.sections[unescapeKey(line+1, length-2)];
+		return;
+	}
+
+	size_t eq = 0;
+	while ((eq < length) && (line[eq] != QLatin1Char('=')))
+		eq++;
+	if (eq == length) {
+		errors.push_back({lineNo, "Missing '='"});
+		return;
+	}
+
+	size_t keyLength = eq;
+	while ((keyLength > 0) && (line[keyLength-1].isSpace()))
+		keyLength--;
+	size_t valueStart = eq+1;
+	while ((valueStart < length) && (line[valueStart].isSpace()))
+		valueStart++;
+
+	if (keyLength == 0) {
+		errors.push_back({lineNo, "Empty key"});
+		return;
+	}
+
+	QString value;
+	if (!unescapeValue(line+valueStart, length-valueStart, value)) {
+		errors.push_back({lineNo, "Unsupported value: " + QString(line+valueStart, static_cast<int>(length-valueStart))});
+		return;
+	}
+	section->values[unescapeKey(line, keyLength)] = value;
+}
+
+static int hexDigit(QChar c) {
+	const char16_t u = c.unicode();
+	if ((u >= u'0') && (u <= u'9'))
+		return u - u'0';
+	if ((u >= u'a') && (u <= u'f'))
+		return u - u'a' + 10;
+	if ((u >= u'A') && (u <= u'F'))
+		return u - u'A' + 10;
+	return -1;
+}
+
+QString IniData::unescapeKey(const QChar *str, size_t length) {
+	// %XX = latin1 character, %UXXXX = UTF-16 code unit, '\' = '/' (see QSettings)
+	QString result;
+	result.reserve(static_cast<int>(length));
+	for (size_t i = 0; i < length; i++) {
+		if ((str[i] == QLatin1Char('%')) && (i+5 < length) && (str[i+1] == QLatin1Char('U')) &&
+		    (hexDigit(str[i+2]) >= 0) && (hexDigit(str[i+3]) >= 0) && (hexDigit(str[i+4]) >= 0) &&
+		    (hexDigit(str[i+5]) >= 0)) {
+			result.append(QChar(static_cast<char16_t>((hexDigit(str[i+2]) << 12) | (hexDigit(str[i+3]) << 8) |
+			                                          (hexDigit(str[i+4]) << 4) | hexDigit(str[i+5]))));
+			i += 5;
+		} else if ((str[i] == QLatin1Char('%')) && (i+2 < length) && (hexDigit(str[i+1]) >= 0) &&
+		           (hexDigit(str[i+2]) >= 0)) {
+			result.append(QChar(static_cast<char16_t>((hexDigit(str[i+1]) << 4) | hexDigit(str[i+2]))));
+			i += 2;
+		} else if (str[i] == QLatin1Char('\\')) {
+			result.append(QLatin1Char('/'));
+		} else {
+			result.append(str[i]);
+		}
+	}
+	return result;
+}
+
+bool IniData::unescapeValue(const QChar *str, size_t length, QString &result) {
+	if ((length > 0) && (str[0] == QLatin1Char('@')))
+		return false; // @Variant, @ByteArray, ...
+
+	result.clear();
+	result.reserve(static_cast<int>(length));
+	bool inQuotes = false;
+
+	for (size_t i = 0; i < length; i++) {
+		const QChar c = str[i];
+		if (c == QLatin1Char('"')) {
+			inQuotes = !inQuotes;
+		} else if ((!inQuotes) && (c == QLatin1Char(','))) {
+			return false; // string list
+		} else if ((!inQuotes) && (c == QLatin1Char(';'))) {
+			break; // comment
+		} else if (c == QLatin1Char('\\')) {
+			if (++i >= length)
+				return false; // line continuation
+			const QChar e = str[i];
+			switch (e.unicode()) {
+			case u'a': result.append(QChar(u'\a')); break;
+			case u'b': result.append(QChar(u'\b')); break;
+			case u'f': result.append(QChar(u'\f')); break;
+			case u'n': result.append(QChar(u'\n')); break;
+			case u'r': result.append(QChar(u'\r')); break;
+			case u't': result.append(QChar(u'\t')); break;
+			case u'v': result.append(QChar(u'\v')); break;
+			case u'x': {
+				unsigned int code = 0;
+				while ((i+1 < length) && (hexDigit(str[i+1]) >= 0))
+					code = ((code << 4) | static_cast<unsigned int>(hexDigit(str[++i]))) & 0xFFFF;
+				result.append(QChar(static_cast<char16_t>(code)));
+				break;
+			}
+			default:
+				if ((e.unicode() >= u'0') && (e.unicode() <= u'7')) {
+					unsigned int code = e.unicode() - u'0';
+					while ((i+1 < length) && (str[i+1].unicode() >= u'0') && (str[i+1].unicode() <= u'7'))
+						code = ((code << 3) | (str[++i].unicode() - u'0')) & 0xFFFF;
+					result.append(QChar(static_cast<char16_t>(code)));
+				} else {
+					result.append(e); // \\, \", \', \?
+				}
+			}
+		} else {
+			result.append(c);
+		}
+	}
+
+	return !inQuotes;
+}
+
+IniData IniData::fromSettings(QSettings &s) {
+	IniData data;
+	for (const QString &key : s.allKeys()) {
+		const int slash = key.indexOf('/');
+		if (slash < 0)
+			data.sections["General"].values[key] = s.value(key).toString();
+		else
+			data.sections[key.left(slash)].values[key.mid(slash+1)] = s.value(key).toString();
+	}
+	return data;
+}
+
+} // namespace RcsXn
@@ -0,0 +1,49 @@
+#ifndef INI_DATA_H
+#define INI_DATA_H
+
+/* Config file parsed into memory in a single pass. Reader understands INI
+ * files written by QSettings (quoted strings, escape sequences, percent-
+ * encoded keys). Constructs it does not support (string lists, @Variant
+ * values, line continuations) are reported as errors with line numbers;
+ * caller falls back to QSettings in such case (fromSettings).
+ */
+
+#include <QSettings>
+#include <QString>
+#include <QVariant>
+#include <map>
+#include <vector>
+
+namespace RcsXn {
+
+struct IniError {
+	unsigned int line;
+	QString message;
+};
+
+struct IniSection {
+	std::map<QString, QString> values;
+
+	QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+};
+
+class IniData {
+public:
+	std::map<QString, IniSection> sections; // keys without section are in "General"
+
+	const IniSection &section(const QString &name) const; // empty section if not present
+
+	// Nonexistent file results in empty data (same as QSettings)
+	static IniData fromFile(const QString &filename, std::vector<IniError> &errors);
+	static IniData fromSettings(QSettings &s);
+
+private:
+	static void parseLine(const QChar *line, size_t length, unsigned int lineNo,
+	                      IniSection *&section, IniData &data, std::vector<IniError> &errors);
+	static QString unescapeKey(const QChar *str, size_t length);
+	static bool unescapeValue(const QChar *str, size_t length, QString &result);
+};
+
+} // namespace RcsXn
+
+#endif // INI_DATA_H
@@ -0,0 +1,129 @@
+#include "input-modules-model.h"
+
+namespace RcsXn {
+
+InputModulesModel::InputModulesModel(const Modules &source, Runner runner, QObject *parent)
+	: QAbstractTableModel(parent), m_source(source), m_runner(std::move(runner)) {
+	QObject::connect(&m_flush_timer, SIGNAL(timeout()), this, SLOT(flush()));
+	m_flush_timer.setSingleShot(true);
+	m_flush_timer.setInterval(GUI_REFRESH_PERIOD);
+}
+
+int InputModulesModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : static_cast<int>(m_modules.size());
+}
+
+int InputModulesModel::columnCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : ColCount;
+}
+
+QVariant InputModulesModel::data(const QModelIndex &index, int role) const {
+	if ((!index.isValid()) || (static_cast<size_t>(index.row()) >= m_modules.size()) ||
+	    (role != Qt::DisplayRole))
+		return QVariant();
+	const RcsInputModule &module = m_modules[static_cast<size_t>(index.row())];
+
+	switch (index.column()) {
+	case ColAddr: return index.row();
+	case ColActive: return module.wantActive ? "✓" : "";
+	case ColName: return module.name;
+	case ColDelays: return delaysStr(module);
+	case ColInputs: return inputsStr(module);
+	}
+	return QVariant();
+}
+
+QVariant InputModulesModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if ((orientation != Qt::Horizontal) || (role != Qt::DisplayRole))
+		return QVariant();
+
+	switch (section) {
+	case ColAddr: return "Modul";
+	case ColActive: return "Aktivní";
+	case ColName: return "Název";
+	case ColDelays: return "Zpoždění vstupů";
+	case ColInputs: return "Stav vstupů";
+	}
+	return QVariant();
+}
+
+QString InputModulesModel::delaysStr(const RcsInputModule &module) {
+	QString delays = "";
+	for (unsigned i = 0; i < module.inputFallDelays.size(); i++) {
+		if (i == (module.inputFallDelays.size()/2))
+			delays += "   ";
+		delays += RcsInputModule::fallDelayToStr(module.inputFallDelays[i]) + "s";
+		if (i < (module.inputFallDelays.size()-1))
+			delays += " ";
+	}
+	return delays;
+}
+
+QString InputModulesModel::inputsStr(const RcsInputModule &module) {
+	QString state = "";
+	for (unsigned i = 0; i < module.state.size(); i++) {
+		if (i == (module.state.size()/2))
+			state += " ";
+
+		if (!module.realActive)
+			state += "-";
+		else if (module.state[i] == XnInState::on)
+			state += "1";
+		else if (module.state[i] == XnInState::off)
+			state += "0";
+		else if (module.state[i] == XnInState::falling)
+			state += "v";
+		else
+			state += "?";
+	}
+	return state;
+}
+
+void InputModulesModel::moduleChanged(unsigned addr) {
+	if (addr >= m_modules.size())
+		return;
+	m_dirty.set(addr, true);
+	if ((m_active) && (!m_flush_timer.isActive()))
+		m_flush_timer.start();
+}
+
+void InputModulesModel::reload() {
+	m_flush_timer.stop();
+	m_dirty.reset();
+	this->beginResetModel();
+	m_runner([this]() { m_modules = m_source; });
+	this->endResetModel();
+}
+
+void InputModulesModel::setActive(bool active) {
+	if (active == m_active)
+		return;
+	m_active = active;
+	if (active)
+		this->flush();
+	else
+		m_flush_timer.stop();
+}
+
+void InputModulesModel::flush() {
+	if (m_dirty.findNext(true, 0) >= IO_IN_MODULES_COUNT)
+		return;
+
+	m_runner([this]() {
+		for (size_t addr = m_dirty.findNext(true, 0); addr < IO_IN_MODULES_COUNT;
+		     addr = m_dirty.findNext(true, addr+1))
+			m_modules[addr] = m_source[addr];
+	});
+
+	// Contiguous dirty rows are reported as single range
+	size_t first = m_dirty.findNext(true, 0);
+	while (first < IO_IN_MODULES_COUNT) {
+		const size_t last = m_dirty.findNext(false, first) - 1;
+		emit dataChanged(this->index(static_cast<int>(first), 0),
+		                 this->index(static_cast<int>(last), ColCount-1));
+		first = m_dirty.findNext(true, last+1);
+	}
+	m_dirty.reset();
+}
+
+} // namespace RcsXn
@@ -0,0 +1,71 @@
+#ifndef INPUT_MODULES_MODEL_H
+#define INPUT_MODULES_MODEL_H
+
+/* Input modules table of the configuration dialog. Texts of rows are built
+ * only when view paints them. Changed modules are just marked dirty and
+ * reported to views in batches at most once per GUI_REFRESH_PERIOD; while
+ * the model is inactive (dialog hidden), no signals are emitted at all and
+ * all dirty rows are reported at once after activation.
+ *
+ * Modules live in XN thread, so the model keeps its own copy of them. Dirty
+ * rows are copied in a batch via runner, which executes given function in
+ * thread owning source modules.
+ */
+
+#include <QAbstractTableModel>
+#include <QTimer>
+#include <array>
+#include <functional>
+
+#include "bit-array.h"
+#include "common.h"
+#include "rcsinputmodule.h"
+
+namespace RcsXn {
+
+class InputModulesModel : public QAbstractTableModel {
+	Q_OBJECT
+
+public:
+	enum Column {
+		ColAddr = 0,
+		ColActive = 1,
+		ColName = 2,
+		ColDelays = 3,
+		ColInputs = 4,
+		ColCount = 5,
+	};
+
+	using Modules = std::array<RcsInputModule, IO_IN_MODULES_COUNT>;
+	using Runner = std::function<void(const std::function<void()> &)>;
+
+	InputModulesModel(const Modules &source, Runner runner, QObject *parent = nullptr);
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation,
+	                    int role = Qt::DisplayRole) const override;
+
+	void moduleChanged(unsigned addr); // cheap, view is updated later
+	void reload(); // all modules could have changed
+	void setActive(bool active);
+
+	static QString delaysStr(const RcsInputModule &);
+	static QString inputsStr(const RcsInputModule &);
+
+private slots:
+	void flush();
+
+private:
+	const Modules &m_source;
+	Runner m_runner;
+	Modules m_modules; // copy of m_source, updated in flush() & reload()
+	BitArray<IO_IN_MODULES_COUNT> m_dirty;
+	QTimer m_flush_timer;
+	bool m_active = false;
+};
+
+} // namespace RcsXn
+
+#endif // INPUT_MODULES_MODEL_H
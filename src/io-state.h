@@ -0,0 +1,154 @@
+#ifndef IO_STATE_H
+#define IO_STATE_H
+
+/* I/O state published by XN thread for API functions called from any
+ * thread (e.g. several worker threads of hJOPserver). State of each module
+ * is packed into a single atomic word, so reader always gets consistent view
+ * of the whole module without any lock and without retrying. XN thread is
+ * the only writer of the real state; it republishes module after each change
+ * of its state.
+ *
+ * Writes of outputs (SetOutput) are performed in XN thread asynchronously, so
+ * API thread applies them to published state of the output module in advance
+ * (beginOutWrite) and XN thread republishes the real state once the last
+ * pending write of the module is performed (endOutWrite). Until then, XN
+ * thread republishes everything except outputs & signal code.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.h"
+
+namespace RcsXn {
+
+struct InModuleState {
+	uint8_t inputs = 0; // bit n = input n+1 is on (including falling)
+	bool wantActive = false;
+	bool realActive = false;
+	bool provisional = false; // state from snapshot, not scanned yet
+};
+
+constexpr unsigned int OUT_SIGNAL_CODES_PUBLISHED = 17;
+
+struct OutModuleState {
+	uint8_t outputs = 0; // bit n = output n is on
+	bool active = false;
+	bool signal = false;
+	bool binary = false;
+	bool addrInvalid = false; // module is not valid in address range (Lenz module 0)
+	bool signalAddrInvalid = false; // first output module of signal is not valid
+	unsigned int signalCode = 0; // valid only for signal
+	uint32_t signalCodes = 0; // bit n = code n has aspect, n < OUT_SIGNAL_CODES_PUBLISHED
+	bool signalOtherCodes = false; // some code >= OUT_SIGNAL_CODES_PUBLISHED has aspect
+};
+
+class IoState {
+public:
+	InModuleState in(std::size_t module) const {
+		const uint32_t word = this->m_in[module].load(std::memory_order_acquire);
+		InModuleState state;
+		state.inputs = static_cast<uint8_t>(word & 0xFF);
+		state.wantActive = (word >> 8) & 1;
+		state.realActive = (word >> 9) & 1;
+		state.provisional = (word >> 10) & 1;
+		return state;
+	}
+
+	OutModuleState out(std::size_t module) const {
+		return unpackOut(this->m_out[module].load(std::memory_order_acquire));
+	}
+
+	void setIn(std::size_t module, const InModuleState &state) {
+		const uint32_t word = state.inputs | (uint32_t{state.wantActive} << 8) |
+		                      (uint32_t{state.realActive} << 9) |
+		                      (uint32_t{state.provisional} << 10);
+		this->m_in[module].store(word, std::memory_order_release);
+	}
+
+	// Real state from XN thread; outputs & signal code of module with pending writes are kept
+	void setOut(std::size_t module, const OutModuleState &state) {
+		this->updateOut(module, state, 0);
+	}
+
+	// API thread: write(state) applies the write to state & returns its result
+	template <typename F>
+	int beginOutWrite(std::size_t module, F &&write) {
+		uint64_t word = this->m_out[module].load(std::memory_order_relaxed);
+		uint64_t desired;
+		int result;
+		do {
+			OutModuleState state = unpackOut(word);
+			result = write(state);
+			desired = (packOut(state) | (word & OUT_PENDING_MASK)) + OUT_PENDING_ONE;
+		} while (!this->m_out[module].compare_exchange_weak(word, desired,
+		                                                    std::memory_order_acq_rel));
+		return result;
+	}
+
+	// XN thread: write begun by beginOutWrite performed, state = real state after it
+	void endOutWrite(std::size_t module, const OutModuleState &state) {
+		this->updateOut(module, state, OUT_PENDING_ONE);
+	}
+
+	// disableSetOutputOff active and track is not powered (see RcsXn::setPlainOutput)
+	void setOutputsRejected(bool rejected) {
+		this->m_outputsRejected.store(rejected, std::memory_order_release);
+	}
+	bool outputsRejected() const { return this->m_outputsRejected.load(std::memory_order_acquire); }
+
+private:
+	// Output word: bits 0-1 outputs, 2 active, 3 signal, 4 binary, 5 addrInvalid,
+	// 6 signalAddrInvalid, 7 signalOtherCodes, 8-24 signalCodes, 25-39 pending writes,
+	// 40-63 signalCode
+	static constexpr uint64_t OUT_PENDING_ONE = uint64_t{1} << 25;
+	static constexpr uint64_t OUT_PENDING_MASK = uint64_t{0x7FFF} << 25;
+	static constexpr uint64_t OUT_WRITE_MASK = 0x3u | (uint64_t{0xFFFFFF} << 40);
+
+	std::array<std::atomic<uint32_t>, IO_IN_MODULES_COUNT> m_in {};
+	std::array<std::atomic<uint64_t>, IO_OUT_MODULES_COUNT> m_out {};
+	std::atomic<bool> m_outputsRejected {false};
+
+	void updateOut(std::size_t module, const OutModuleState &state, uint64_t done) {
+		uint64_t word = this->m_out[module].load(std::memory_order_relaxed);
+		uint64_t desired;
+		do {
+			const uint64_t pending = (word & OUT_PENDING_MASK) - done;
+			desired = packOut(state) | pending;
+			if (pending != 0)
+				desired = (desired & ~OUT_WRITE_MASK) | (word & OUT_WRITE_MASK);
+		} while (!this->m_out[module].compare_exchange_weak(word, desired,
+		                                                    std::memory_order_acq_rel));
+	}
+
+	static uint64_t packOut(const OutModuleState &state) {
+		static_assert(IO_OUT_MODULE_PIN_COUNT <= 2, "Outputs do not fit into OutModuleState");
+		static_assert(OUT_SIGNAL_CODES_PUBLISHED <= 17, "Signal codes do not fit into word");
+		return (state.outputs & 0x3u) | (uint64_t{state.active} << 2) |
+		       (uint64_t{state.signal} << 3) | (uint64_t{state.binary} << 4) |
+		       (uint64_t{state.addrInvalid} << 5) | (uint64_t{state.signalAddrInvalid} << 6) |
+		       (uint64_t{state.signalOtherCodes} << 7) |
+		       (uint64_t{state.signalCodes & 0x1FFFFu} << 8) |
+		       (uint64_t{state.signalCode & 0xFFFFFFu} << 40);
+	}
+
+	static OutModuleState unpackOut(uint64_t word) {
+		OutModuleState state;
+		state.outputs = static_cast<uint8_t>(word & 0x3);
+		state.active = (word >> 2) & 1;
+		state.signal = (word >> 3) & 1;
+		state.binary = (word >> 4) & 1;
+		state.addrInvalid = (word >> 5) & 1;
+		state.signalAddrInvalid = (word >> 6) & 1;
+		state.signalOtherCodes = (word >> 7) & 1;
+		state.signalCodes = static_cast<uint32_t>((word >> 8) & 0x1FFFF);
+		state.signalCode = static_cast<unsigned int>(word >> 40);
+		return state;
+	}
+};
+
+} // namespace RcsXn
+
+#endif // IO_STATE_H
@@ -1,32 +1,53 @@
+#include <functional>
+#include <map>
+#include <vector>
+
 #include "lib-api.h"
 #include "errors.h"
 #include "rcs-xn.h"
 #include "util.h"
+#include "xn-thread.h"
+#ifndef RCS_XN_HEADLESS
+#include "rcs-xn-gui.h"
+#endif
 
-/* This file deafines all library exported API functions. */
+/* This file deafines all library exported API functions.
+ *
+ * RcsXn lives in XN thread (see xn-thread.h). State-changing functions are
+ * executed in XN thread via xn_thread.call, caller waits for their result.
+ * SetOutput(s) is validated & applied to published state and only queued.
+ * Queries of I/O and module state read atomic values (rx.io, see io-state.h)
+ * and never block, so they could be called from several threads at once.
+ */
 
 namespace RcsXn {
 
 unsigned int rcs_api_version = 0;
 
+static RcsStartState startState() {
+	return xn_thread.alive() ? rx.started.load() : RcsStartState::stopped;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Open/close
 
 int Open() {
 	try {
-		return rx.openDevice(rx.s["XN"]["port"].toString(), false);
+		return xn_thread.call([&]() -> int {
+			return rx.openDevice(rx.s["XN"]["port"].toString(), false);
+		});
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 int Close() {
 	try {
-		return rx.close();
+		return xn_thread.call([&]() { return rx.close(); });
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 bool Opened() {
 	try {
-		return (rx.xn.connected() && (!rx.opening));
+		return (xn_thread.alive() && rx.connected && (!rx.opening));
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
@@ -35,19 +56,19 @@ bool Opened() {
 
 int Start() {
 	try {
-		return rx.start();
+		return xn_thread.call([&]() { return rx.start(); });
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 int Stop() {
 	try {
-		return rx.stop();
+		return xn_thread.call([&]() { return rx.stop(); });
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 bool Started() {
 	try {
-		return (rx.started > RcsStartState::stopped);
+		return (startState() > RcsStartState::stopped);
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
@@ -55,26 +76,36 @@ bool Started() {
 // Config
 
 int LoadConfig(char16_t *filename) {
-	if (rx.xn.connected())
-		return RCS_FILE_DEVICE_OPENED;
-	try {
-		rx.config_filename = QString::fromUtf16(filename);
-		rx.loadConfig(QString::fromUtf16(filename));
-	} catch (const QStrException& e) {
-		rx.log(e.str(), RcsXnLogLevel::llError);
-		return RCS_FILE_CANNOT_ACCESS;
+	const QString fn = QString::fromUtf16(filename);
+	try {
+		return xn_thread.call([&fn]() -> int {
+			if (rx.xn.connected())
+				return RCS_FILE_DEVICE_OPENED;
+			try {
+				rx.config_filename = fn;
+				rx.loadConfig(fn);
+			} catch (const QStrException& e) {
+				rx.log(e.str(), RcsXnLogLevel::llError);
+				return RCS_FILE_CANNOT_ACCESS;
+			}
+			return 0;
+		});
 	} catch (...) { return RCS_FILE_CANNOT_ACCESS; }
-	return 0;
 }
 
 int SaveConfig(char16_t *filename) {
+	const QString fn = QString::fromUtf16(filename);
 	try {
-		rx.saveConfig(QString::fromUtf16(filename));
-	} catch (const QStrException& e) {
-		rx.log(e.str(), RcsXnLogLevel::llError);
-		return RCS_FILE_CANNOT_ACCESS;
+		return xn_thread.call([&fn]() -> int {
+			try {
+				rx.saveConfig(fn);
+			} catch (const QStrException& e) {
+				rx.log(e.str(), RcsXnLogLevel::llError);
+				return RCS_FILE_CANNOT_ACCESS;
+			}
+			return 0;
+		});
 	} catch (...) { return RCS_FILE_CANNOT_ACCESS; }
-	return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -82,25 +113,67 @@ int SaveConfig(char16_t *filename) {
 
 void SetLogLevel(unsigned int loglevel) {
 	try {
-		rx.setLogLevel(static_cast<RcsXnLogLevel>(loglevel));
+		xn_thread.call([&]() { rx.setLogLevel(static_cast<RcsXnLogLevel>(loglevel)); });
 	} catch (...) {}
 }
 
-unsigned int GetLogLevel() { return static_cast<unsigned int>(rx.loglevel); }
+unsigned int GetLogLevel() {
+	try {
+		return xn_thread.call([]() { return static_cast<unsigned int>(rx.loglevel); });
+	} catch (...) { return 0; }
+}
+
+void SetHostLogLevel(unsigned int loglevel) {
+	try {
+		xn_thread.call([&]() { rx.setHostLogLevel(static_cast<RcsXnLogLevel>(loglevel)); });
+	} catch (...) {}
+}
+
+unsigned int GetHostLogLevel() {
+	try {
+		return xn_thread.call([]() { return static_cast<unsigned int>(rx.loglevel_host); });
+	} catch (...) { return 0; }
+}
+
+int SetLogAsync(bool enabled, unsigned int capacity, unsigned int dropPolicy) {
+	try {
+		return xn_thread.call([&]() -> int {
+			if (dropPolicy > static_cast<unsigned int>(LogDropPolicy::dropOldest))
+				return RCS_GENERAL_EXCEPTION;
+			rx.setLogAsync(enabled, capacity, static_cast<LogDropPolicy>(dropPolicy));
+			return 0;
+		});
+	} catch (...) { return RCS_GENERAL_EXCEPTION; }
+}
+
+unsigned int GetLogDroppedCount() {
+	return xn_thread.alive() ? static_cast<unsigned int>(rx.logDroppedCount()) : 0;
+}
+
+void Shutdown() {
+	try {
+		xn_thread.shutdown();
+	} catch (...) {}
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // UI
 
+// No-op in headless build
 void ShowConfigDialog() {
+#ifndef RCS_XN_HEADLESS
 	try {
-		rx.form.show();
+		gui.form.show();
 	} catch (...) {}
+#endif
 }
 
 void HideConfigDialog() {
+#ifndef RCS_XN_HEADLESS
 	try {
-		rx.form.close();
+		gui.form.close();
 	} catch (...) {}
+#endif
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -108,10 +181,14 @@ void HideConfigDialog() {
 
 int GetInput(unsigned int module, unsigned int port) {
 	try {
-		if (rx.started == RcsStartState::stopped)
+		const RcsStartState started = startState();
+		if (started == RcsStartState::stopped)
 			return RCS_NOT_STARTED;
-		if ((module >= IO_IN_MODULES_COUNT) || (!rx.modules_in[module].realActive))
-			return (rx.modules_in[module].wantActive) ? RCS_MODULE_FAILED : RCS_MODULE_INVALID_ADDR;
+		if (module >= IO_IN_MODULES_COUNT)
+			return RCS_MODULE_INVALID_ADDR;
+		const InModuleState state = rx.io.in(module);
+		if (!state.realActive)
+			return (state.wantActive) ? RCS_MODULE_FAILED : RCS_MODULE_INVALID_ADDR;
 		if ((port > IO_IN_MODULE_PIN_COUNT) || (port == 0)) { // ports 1-8, not 0-7!
 #ifdef IGNORE_PIN_BOUNDS
 			return 0;
@@ -119,19 +196,62 @@ int GetInput(unsigned int module, unsigned int port) {
 			return RCS_PORT_INVALID_NUMBER;
 #endif
 		}
-		if (rx.started == RcsStartState::scanning)
+		if ((started == RcsStartState::scanning) && (!state.provisional))
+			return RCS_INPUT_NOT_YET_SCANNED;
+
+		return (state.inputs >> (port-1)) & 1;
+	} catch (...) { return RCS_GENERAL_EXCEPTION; }
+}
+
+int GetModuleInputs(unsigned int module, uint8_t *mask) {
+	try {
+		const RcsStartState started = startState();
+		if (started == RcsStartState::stopped)
+			return RCS_NOT_STARTED;
+		if (mask == nullptr)
+			return RCS_GENERAL_EXCEPTION;
+		if (module >= IO_IN_MODULES_COUNT)
+			return RCS_MODULE_INVALID_ADDR;
+		const InModuleState state = rx.io.in(module);
+		if (!state.realActive)
+			return (state.wantActive) ? RCS_MODULE_FAILED : RCS_MODULE_INVALID_ADDR;
+		if ((started == RcsStartState::scanning) && (!state.provisional))
 			return RCS_INPUT_NOT_YET_SCANNED;
 
-		return ((rx.modules_in[module].state[port-1] == XnInState::on) ||
-		        (rx.modules_in[module].state[port-1] == XnInState::falling));
+		*mask = state.inputs;
+		return 0;
+	} catch (...) { return RCS_GENERAL_EXCEPTION; }
+}
+
+int GetInputsBitmap(uint8_t *buf, unsigned int len) {
+	try {
+		// byte n = module n, bit m = input m+1 of the module; failed modules are all-zero
+		// while scanning, modules not scanned yet (and without provisional state) are all-zero
+		const RcsStartState started = startState();
+		if (started == RcsStartState::stopped)
+			return RCS_NOT_STARTED;
+		if (buf == nullptr)
+			return RCS_GENERAL_EXCEPTION;
+
+		const bool scanning = (started == RcsStartState::scanning);
+		const unsigned int count = std::min<unsigned int>(len, IO_IN_MODULES_COUNT);
+		for (unsigned int module = 0; module < count; module++) {
+			const InModuleState state = rx.io.in(module);
+			const bool known = (state.realActive) && ((!scanning) || (state.provisional));
+			buf[module] = (known) ? state.inputs : 0;
+		}
+		return 0;
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 int GetOutput(unsigned int module, unsigned int port) {
 	try {
-		if (rx.started == RcsStartState::stopped)
+		if (startState() == RcsStartState::stopped)
 			return RCS_NOT_STARTED;
-		if ((module >= IO_OUT_MODULES_COUNT) || (!rx.user_active_out[module]))
+		if (module >= IO_OUT_MODULES_COUNT)
+			return RCS_MODULE_INVALID_ADDR;
+		const OutModuleState state = rx.io.out(module);
+		if (!state.active)
 			return RCS_MODULE_INVALID_ADDR;
 		if (port >= IO_OUT_MODULE_PIN_COUNT) {
 	#ifdef IGNORE_PIN_BOUNDS
@@ -141,20 +261,74 @@ int GetOutput(unsigned int module, unsigned int port) {
 	#endif
 		}
 
-		unsigned int portAddr = (module<<1) + (port&1); // 0-2047
-		if (rx.isSignal(portAddr)) {
-			const XnSignal &sig = rx.sig.at(portAddr/2);
-			return static_cast<int>(sig.currentCode);
-		}
-		return rx.outputs[portAddr];
+		if ((state.signal) && (!(port&1))) // signal is on the even port of the module
+			return static_cast<int>(state.signalCode);
+		return (state.outputs >> (port&1)) & 1;
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
+// Writes are performed in XN thread without waiting (see lib-api.h). Result of the write is
+// determined from published state, which is updated in advance, so GetOutput reflects the write
+// immediately. XN thread republishes real state of modules after performing the write.
+
+// Applies write to published state of module; returns result of RcsXn::setOutput
+static int writeOutput(OutModuleState &out, unsigned int port, int state, bool rejected) {
+	if ((out.signal) && (!(port&1))) {
+		// RcsXn::setSignal; outputs of the current aspect are not sent again
+		const unsigned int code = static_cast<unsigned int>(state);
+		const bool sent = (code != out.signalCode);
+		out.signalCode = code;
+		const bool defined = (code < OUT_SIGNAL_CODES_PUBLISHED) ? ((out.signalCodes >> code) & 1)
+		                                                         : out.signalOtherCodes;
+		if (!defined)
+			return RCS_INVALID_SCOM_CODE;
+		if (out.signalAddrInvalid)
+			return RCS_PORT_INVALID_NUMBER;
+		return ((rejected) && (sent)) ? RCS_MODULE_INVALID_ADDR : 0;
+	}
+
+	// RcsXn::setOutput & setPlainOutput
+	if ((out.binary) && (state == 0)) {
+		port = (!port)&1;
+		state = 1;
+	}
+	const uint8_t bit = static_cast<uint8_t>(1 << (port&1));
+	if (static_cast<bool>(out.outputs & bit) == static_cast<bool>(state))
+		return 0;
+	if (state > 0)
+		out.outputs = bit; // second port of the pair is turned off
+	else if (state < 0)
+		out.outputs |= bit;
+	else
+		out.outputs &= static_cast<uint8_t>(~bit);
+	if (out.addrInvalid)
+		return RCS_PORT_INVALID_NUMBER;
+	return (rejected) ? RCS_MODULE_INVALID_ADDR : 0;
+}
+
+// modules: one item per write begun by beginOutWrite
+template <typename F>
+static void postOutputs(std::vector<unsigned int> modules, int expected, F f) {
+	xn_thread.post([modules, expected, f]() {
+		try {
+			// State could change since the write was accepted -> validated again
+			const int ret = (rx.started == RcsStartState::stopped) ? RCS_NOT_STARTED : f();
+			if (ret != expected)
+				rx.log("Nastavení výstupu selhalo, kód chyby " + QString::number(ret) + ".",
+				       RcsXnLogLevel::llWarning);
+		} catch (...) {
+			rx.log("Nastavení výstupu selhalo: výjimka.", RcsXnLogLevel::llError);
+		}
+		for (unsigned int module : modules)
+			rx.outputWritten(module);
+	});
+}
+
 int SetOutput(unsigned int module, unsigned int port, int state) {
 	try {
-		if (rx.started == RcsStartState::stopped)
+		if (startState() == RcsStartState::stopped)
 			return RCS_NOT_STARTED;
-		if ((module >= IO_OUT_MODULES_COUNT) || (!rx.user_active_out[module]))
+		if ((module >= IO_OUT_MODULES_COUNT) || (!rx.io.out(module).active))
 			return RCS_MODULE_INVALID_ADDR;
 		if (port >= IO_OUT_MODULE_PIN_COUNT) {
 #ifdef IGNORE_PIN_BOUNDS
@@ -164,47 +338,125 @@ int SetOutput(unsigned int module, unsigned int port, int state) {
 #endif
 		}
 
-		unsigned int portAddr = (module<<1) + (port&1); // 0-2047
+		const bool rejected = rx.io.outputsRejected();
+		const int ret = rx.io.beginOutWrite(module, [port, state, rejected](OutModuleState &out) {
+			return writeOutput(out, port, state, rejected);
+		});
+		postOutputs({module}, ret, [module, port, state]() -> int {
+			if (!rx.user_active_out[module])
+				return RCS_MODULE_INVALID_ADDR;
+			return rx.setOutput(module, port, state);
+		});
+		return ret;
+	} catch (...) { return RCS_GENERAL_EXCEPTION; }
+}
 
-		if (rx.isSignal(portAddr))
-			return rx.setSignal(static_cast<uint16_t>(portAddr), static_cast<unsigned int>(state));
+int SetOutputs(const RcsOutputCmd *cmds, unsigned int count) {
+	try {
+		if (startState() == RcsStartState::stopped)
+			return RCS_NOT_STARTED;
+		if ((cmds == nullptr) && (count > 0))
+			return RCS_GENERAL_EXCEPTION;
+
+		// Whole batch is validated first, nothing is set when any command is invalid
+		std::vector<OutputCmd> batch;
+		batch.reserve(count);
+		for (unsigned int i = 0; i < count; i++) {
+			if ((cmds[i].module >= IO_OUT_MODULES_COUNT) || (!rx.io.out(cmds[i].module).active))
+				return RCS_MODULE_INVALID_ADDR;
+			if (cmds[i].port >= IO_OUT_MODULE_PIN_COUNT) {
+#ifdef IGNORE_PIN_BOUNDS
+				continue;
+#else
+				return RCS_PORT_INVALID_NUMBER;
+#endif
+			}
+			batch.push_back({cmds[i].module, cmds[i].port, cmds[i].state});
+		}
 
-		if ((rx.binary[module]) && (state == 0)) {
-			portAddr = (module<<1) + ((!port)&1);
-			state = 1;
+		// Same order as RcsXn::setOutputs: last write of each port, in order of its first write
+		std::map<unsigned int, size_t> lastCmd; // port address -> index in batch
+		std::vector<unsigned int> order;
+		for (size_t i = 0; i < batch.size(); i++) {
+			const unsigned int portAddr = (batch[i].module<<1) + (batch[i].port&1);
+			if (lastCmd.find(portAddr) == lastCmd.end())
+				order.push_back(portAddr);
+			lastCmd[portAddr] = i;
 		}
-		if (rx.outputs[portAddr] == static_cast<bool>(state))
+
+		const bool rejected = rx.io.outputsRejected();
+		std::vector<unsigned int> modules;
+		modules.reserve(order.size());
+		int ret = 0;
+		for (unsigned int portAddr : order) {
+			const OutputCmd &cmd = batch[lastCmd[portAddr]];
+			const int subret = rx.io.beginOutWrite(cmd.module,
+				[&cmd, rejected](OutModuleState &out) {
+					return writeOutput(out, cmd.port, cmd.state, rejected);
+				});
+			modules.push_back(cmd.module);
+			if ((subret != 0) && (ret == 0))
+				ret = subret;
+		}
+
+		postOutputs(std::move(modules), ret, [batch]() -> int {
+			for (const OutputCmd &cmd : batch)
+				if (!rx.user_active_out[cmd.module])
+					return RCS_MODULE_INVALID_ADDR;
+			return rx.setOutputs(batch);
+		});
+		return ret;
+	} catch (...) { return RCS_GENERAL_EXCEPTION; }
+}
+
+int GetOutputQueueStats(unsigned int priority, RcsOutputQueueStats *stats) {
+	try {
+		return xn_thread.call([&]() -> int {
+			if ((priority >= OUTPUT_PRIORITIES_COUNT) || (stats == nullptr))
+				return RCS_GENERAL_EXCEPTION;
+
+			const OutputQueueStats &qs = rx.outputQueueStats(static_cast<OutputPriority>(priority));
+			stats->depth = static_cast<unsigned int>(qs.depth);
+			stats->sent = static_cast<unsigned int>(qs.sent);
+			stats->lastWait = static_cast<unsigned int>(qs.lastWait);
+			stats->maxWait = static_cast<unsigned int>(qs.maxWait);
+			stats->avgWait = (qs.sent > 0) ? static_cast<unsigned int>(qs.totalWait / qs.sent) : 0;
+			stats->superseded = static_cast<unsigned int>(qs.superseded);
 			return 0;
-		return rx.setPlainOutput(portAddr, state, true);
+		});
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 bool IsSimulation() {
 	try {
-		return rx.s["global"]["mockInputs"].toBool();
+		return xn_thread.call([&]() { return rx.config().mockInputs; });
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 int SetInput(unsigned int module, unsigned int port, int state) {
 	try {
-		// only debug method
-		if (!rx.s["global"]["mockInputs"].toBool())
-			return 0;
-		if (rx.started == RcsStartState::stopped)
-			return 0;
-		if ((module >= IO_IN_MODULES_COUNT) || (!rx.modules_in[module].wantActive))
-			return (rx.modules_in[module].wantActive) ? RCS_MODULE_FAILED : RCS_MODULE_INVALID_ADDR;
-		if ((port > IO_IN_MODULE_PIN_COUNT) || (port == 0)) { // ports 1-8, not 0-7!
+		return xn_thread.call([&]() -> int {
+			// only debug method
+			if (!rx.config().mockInputs)
+				return 0;
+			if (rx.started == RcsStartState::stopped)
+				return 0;
+			if ((module >= IO_IN_MODULES_COUNT) || (!rx.modules_in[module].wantActive))
+				return (rx.modules_in[module].wantActive) ? RCS_MODULE_FAILED
+				                                          : RCS_MODULE_INVALID_ADDR;
+			if ((port > IO_IN_MODULE_PIN_COUNT) || (port == 0)) { // ports 1-8, not 0-7!
 #ifdef IGNORE_PIN_BOUNDS
-			return 0;
+				return 0;
 #else
-			return RCS_PORT_INVALID_NUMBER;
+				return RCS_PORT_INVALID_NUMBER;
 #endif
-		}
+			}
 
-		rx.modules_in[module].state[port-1] = (state == 1) ? XnInState::on : XnInState::off;
-		rx.events.call(rx.events.onInputChanged, module);
-		return 0;
+			rx.modules_in[module].state.set(port-1, (state == 1) ? XnInState::on : XnInState::off);
+			rx.updateInputsBitmap(module);
+			rx.events.call(rx.events.onInputChanged, module);
+			return 0;
+		});
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
@@ -218,21 +470,24 @@ int GetInputType(unsigned int module, unsigned int port) {
 
 int GetOutputType(unsigned int module, unsigned int port) {
 	try {
-		unsigned int portAddr = (module<<1) + (port&1); // 0-2047
-		return rx.isSignal(portAddr) ? 1 : 0;
+		if ((!xn_thread.alive()) || (module >= IO_OUT_MODULES_COUNT))
+			return 0;
+		return ((rx.io.out(module).signal) && (!(port&1))) ? 1 : 0;
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Module questionaries
 
-unsigned int GetModuleCount() { return rx.modules_count; }
+unsigned int GetModuleCount() { return xn_thread.alive() ? rx.modules_count.load() : 0; }
 
 bool IsModule(unsigned int module) {
 	try {
-		if (module < IO_IN_MODULES_COUNT && rx.modules_in[module].wantActive)
+		if (!xn_thread.alive())
+			return false;
+		if (module < IO_IN_MODULES_COUNT && rx.io.in(module).wantActive)
 			return true;
-		if (module < IO_OUT_MODULES_COUNT && rx.user_active_out[module])
+		if (module < IO_OUT_MODULES_COUNT && rx.io.out(module).active)
 			return true;
 		return false;
 	} catch (...) { return false; }
@@ -244,9 +499,14 @@ bool IsModuleFailure(unsigned int module) {
 	try {
 		// Output module is always marked as active - so outputs
 		// could be set even if input module is absent.
-		if (module < IO_OUT_MODULES_COUNT && rx.user_active_out[module])
+		if (startState() != RcsStartState::started)
 			return false;
-		return (rx.started == RcsStartState::started && module < IO_IN_MODULES_COUNT && rx.modules_in[module].wantActive && !rx.modules_in[module].realActive);
+		if (module < IO_OUT_MODULES_COUNT && rx.io.out(module).active)
+			return false;
+		if (module >= IO_IN_MODULES_COUNT)
+			return false;
+		const InModuleState state = rx.io.in(module);
+		return (state.wantActive && !state.realActive);
 	} catch (...) { return false; }
 }
 
@@ -261,11 +521,14 @@ int GetModuleTypeStr(unsigned int module, char16_t *type, unsigned int typeLen)
 
 int GetModuleName(unsigned int module, char16_t *name, unsigned int nameLen) {
 	try {
-		if (module >= std::max(IO_IN_MODULES_COUNT, IO_OUT_MODULES_COUNT))
-			return RCS_MODULE_INVALID_ADDR;
-		const QString str = rx.modules_in[module].name;
-		StrUtil::strcpy<char16_t>(reinterpret_cast<const char16_t *>(str.utf16()), name, nameLen);
-		return 0;
+		return xn_thread.call([&]() -> int {
+			if (module >= std::max(IO_IN_MODULES_COUNT, IO_OUT_MODULES_COUNT))
+				return RCS_MODULE_INVALID_ADDR;
+			const QString str = rx.modules_in[module].name;
+			StrUtil::strcpy<char16_t>(reinterpret_cast<const char16_t *>(str.utf16()), name,
+			                          nameLen);
+			return 0;
+		});
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
@@ -283,9 +546,9 @@ unsigned int GetModuleInputsCount(unsigned int module) {
 	try {
 		if (module >= std::max(IO_IN_MODULES_COUNT, IO_OUT_MODULES_COUNT))
 			return RCS_MODULE_INVALID_ADDR;
-		if (module >= IO_IN_MODULES_COUNT)
+		if ((module >= IO_IN_MODULES_COUNT) || (!xn_thread.alive()))
 			return 0; // intentionally not RCS_MODULE_INVALID_ADDR
-		return rx.modules_in[module].wantActive ? IO_IN_MODULE_PIN_COUNT+1 : 0; // pin 0 ignored, indexing from 1
+		return rx.io.in(module).wantActive ? IO_IN_MODULE_PIN_COUNT+1 : 0; // pin 0 ignored, indexing from 1
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
@@ -293,11 +556,12 @@ unsigned int GetModuleOutputsCount(unsigned int module) {
 	try {
 		if (module >= std::max(IO_IN_MODULES_COUNT, IO_OUT_MODULES_COUNT))
 			return RCS_MODULE_INVALID_ADDR;
-		if (module >= IO_OUT_MODULES_COUNT)
+		if ((module >= IO_OUT_MODULES_COUNT) || (!xn_thread.alive()))
 			return 0; // intentionally not RCS_MODULE_INVALID_ADDR
-		if (!rx.user_active_out[module])
+		const OutModuleState state = rx.io.out(module);
+		if (!state.active)
 			return 0;
-		if (rx.isSignal(module*IO_OUT_MODULE_PIN_COUNT))
+		if (state.signal)
 			return 1; // signal -> just one output
 		return IO_OUT_MODULE_PIN_COUNT;
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
@@ -335,11 +599,13 @@ int ApiSetVersion(unsigned int version) {
 
 unsigned int GetDeviceVersion(char16_t *version, unsigned int versionLen) {
 	try {
-		const QString sversion = "LI HW: " + QString::number(rx.li_ver_hw) + ", LI SW: " +
-								  QString::number(rx.li_ver_sw);
-		StrUtil::strcpy<char16_t>(reinterpret_cast<const char16_t *>(sversion.utf16()), version,
-								  versionLen);
-		return 0;
+		return xn_thread.call([&]() -> unsigned int {
+			const QString sversion = "LI HW: " + QString::number(rx.li_ver_hw) + ", LI SW: " +
+									  QString::number(rx.li_ver_sw);
+			StrUtil::strcpy<char16_t>(reinterpret_cast<const char16_t *>(sversion.utf16()), version,
+									  versionLen);
+			return 0;
+		});
 	} catch (...) { return RCS_GENERAL_EXCEPTION; }
 }
 
@@ -355,27 +621,122 @@ unsigned int GetDriverVersion(char16_t *version, unsigned int versionLen) {
 ///////////////////////////////////////////////////////////////////////////////
 // Events binders
 
-void BindBeforeOpen(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.beforeOpen, f, data); }
-void BindAfterOpen(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.afterOpen, f, data); }
+static void bindEvent(std::function<void(RcsEvents &)> bind) {
+	try {
+		xn_thread.call([&bind]() { bind(rx.events); });
+	} catch (...) {}
+}
+
+void BindBeforeOpen(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.beforeOpen, f, data); });
+}
+void BindAfterOpen(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.afterOpen, f, data); });
+}
 void BindBeforeClose(StdNotifyEvent f, void *data) {
-	rx.events.bind(rx.events.beforeClose, f, data);
+	bindEvent([=](RcsEvents &e) { e.bind(e.beforeClose, f, data); });
+}
+void BindAfterClose(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.afterClose, f, data); });
 }
-void BindAfterClose(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.afterClose, f, data); }
 void BindBeforeStart(StdNotifyEvent f, void *data) {
-	rx.events.bind(rx.events.beforeStart, f, data);
+	bindEvent([=](RcsEvents &e) { e.bind(e.beforeStart, f, data); });
+}
+
+void BindAfterStart(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.afterStart, f, data); });
+}
+void BindBeforeStop(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.beforeStop, f, data); });
+}
+void BindAfterStop(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.afterStop, f, data); });
+}
+void BindOnError(StdErrorEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.onError, f, data); });
+}
+void BindOnLog(StdLogEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) {
+		e.bind(e.onLog, f, data);
+		rx.refreshLogLevel();
+	});
+}
+void BindOnLogBatch(StdLogBatchEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) {
+		e.bind(e.onLogBatch, f, data);
+		rx.refreshLogLevel();
+	});
+}
+
+void BindOnInputChanged(StdModuleChangeEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.onInputChanged, f, data); });
+}
+void BindOnOutputChanged(StdModuleChangeEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.onOutputChanged, f, data); });
+}
+void BindOnModuleChanged(StdModuleChangeEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.onModuleChanged, f, data); });
+}
+
+void BindOnScanned(StdNotifyEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.onScanned, f, data); });
+}
+
+void BindOnSignalsResetProgress(StdProgressEvent f, void *data) {
+	bindEvent([=](RcsEvents &e) { e.bind(e.onSignalsResetProgress, f, data); });
+}
+
+void SetEventsDelivery(bool direct) {
+	bindEvent([direct](RcsEvents &e) { e.directDelivery = direct; });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Event subscriptions
+
+template <typename F>
+static unsigned int subscribe(uint32_t mask, unsigned int firstModule, unsigned int lastModule,
+                              F f, void *data) {
+	try {
+		return xn_thread.call([&]() {
+			return rx.events.subscribe(mask, firstModule, lastModule, f, data);
+		});
+	} catch (...) { return 0; }
 }
 
-void BindAfterStart(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.afterStart, f, data); }
-void BindBeforeStop(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.beforeStop, f, data); }
-void BindAfterStop(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.afterStop, f, data); }
-void BindOnError(StdErrorEvent f, void *data) { rx.events.bind(rx.events.onError, f, data); }
-void BindOnLog(StdLogEvent f, void *data) { rx.events.bind(rx.events.onLog, f, data); }
+unsigned int SubscribeNotify(unsigned int eventMask, StdNotifyEvent f, void *data) {
+	if ((f == nullptr) || (eventMask == 0) || (eventMask & ~EVENTS_NOTIFY_MASK))
+		return 0;
+	return subscribe(eventMask, 0, 0, f, data);
+}
 
-void BindOnInputChanged(StdModuleChangeEvent f, void *data) { rx.events.bind(rx.events.onInputChanged, f, data); }
-void BindOnOutputChanged(StdModuleChangeEvent f, void *data) { rx.events.bind(rx.events.onOutputChanged, f, data); }
-void BindOnModuleChanged(StdModuleChangeEvent f, void *data) { rx.events.bind(rx.events.onModuleChanged, f, data); }
+unsigned int SubscribeModuleChange(unsigned int eventMask, unsigned int firstModule,
+                                   unsigned int lastModule, StdModuleChangeEvent f, void *data) {
+	if ((f == nullptr) || (eventMask == 0) || (eventMask & ~EVENTS_MODULE_MASK) ||
+	    (firstModule > lastModule))
+		return 0;
+	return subscribe(eventMask, firstModule, lastModule, f, data);
+}
 
-void BindOnScanned(StdNotifyEvent f, void *data) { rx.events.bind(rx.events.onScanned, f, data); }
+unsigned int SubscribeError(StdErrorEvent f, void *data) {
+	if (f == nullptr)
+		return 0;
+	return subscribe(eventMask(RcsEventType::onError), 0, 0, f, data);
+}
+
+unsigned int SubscribeSignalsResetProgress(StdProgressEvent f, void *data) {
+	if (f == nullptr)
+		return 0;
+	return subscribe(eventMask(RcsEventType::onSignalsResetProgress), 0, 0, f, data);
+}
+
+int Unsubscribe(unsigned int handle) {
+	try {
+		// Not via XN thread: it may wait for callback running in the caller's or other thread
+		if (!xn_thread.alive())
+			return RCS_GENERAL_EXCEPTION;
+		return rx.events.unsubscribe(handle) ? 0 : RCS_GENERAL_EXCEPTION;
+	} catch (...) { return RCS_GENERAL_EXCEPTION; }
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -4,6 +4,7 @@
 /* This file deafines prototypes of library API functions. */
 
 #include <array>
+#include <cstdint>
 #include <QtCore/QtGlobal>
 
 #include "lib-api-common-def.h"
@@ -17,12 +18,38 @@ constexpr std::array<unsigned int, 6> API_SUPPORTED_VERSIONS {
 
 extern unsigned int rcs_api_version;
 
+struct RcsOutputCmd {
+	unsigned int module;
+	unsigned int port;
+	int state;
+};
+
+struct RcsOutputQueueStats {
+	unsigned int depth; // commands waiting in queue
+	unsigned int sent;
+	unsigned int lastWait; // ms
+	unsigned int maxWait; // ms
+	unsigned int avgWait; // ms
+	unsigned int superseded; // unsent commands replaced by newer command for the same port
+};
+
 extern "C" {
 Q_DECL_EXPORT int CALL_CONV LoadConfig(char16_t *filename);
 Q_DECL_EXPORT int CALL_CONV SaveConfig(char16_t *filename);
 
 Q_DECL_EXPORT void CALL_CONV SetLogLevel(unsigned int loglevel);
 Q_DECL_EXPORT unsigned int CALL_CONV GetLogLevel();
+Q_DECL_EXPORT void CALL_CONV SetHostLogLevel(unsigned int loglevel); // onLog threshold
+Q_DECL_EXPORT unsigned int CALL_CONV GetHostLogLevel();
+// dropPolicy: 0 = drop newest, 1 = drop oldest message when queue is full
+// Logs are delivered from log thread in async mode.
+Q_DECL_EXPORT int CALL_CONV SetLogAsync(bool enabled, unsigned int capacity, unsigned int dropPolicy);
+Q_DECL_EXPORT unsigned int CALL_CONV GetLogDroppedCount();
+
+// Stops XN & log threads (closes connection, saves config); call it before unloading library.
+// Threads cannot be joined while FreeLibrary holds the loader lock. Call it from the thread which
+// loaded the library; events not delivered to it yet are discarded.
+Q_DECL_EXPORT void CALL_CONV Shutdown();
 
 Q_DECL_EXPORT void CALL_CONV ShowConfigDialog();
 Q_DECL_EXPORT void CALL_CONV HideConfigDialog();
@@ -36,8 +63,16 @@ Q_DECL_EXPORT int CALL_CONV Stop();
 Q_DECL_EXPORT bool CALL_CONV Started();
 
 Q_DECL_EXPORT int CALL_CONV GetInput(unsigned int module, unsigned int port);
+Q_DECL_EXPORT int CALL_CONV GetModuleInputs(unsigned int module, uint8_t *mask);
+Q_DECL_EXPORT int CALL_CONV GetInputsBitmap(uint8_t *buf, unsigned int len);
 Q_DECL_EXPORT int CALL_CONV GetOutput(unsigned int module, unsigned int port);
+// SetOutput(s) returns result of the write determined from current state and queues the write
+// without waiting for library thread. GetOutput reflects the write immediately. Writes are
+// performed in order; different result caused by change of state in meantime is logged.
 Q_DECL_EXPORT int CALL_CONV SetOutput(unsigned int module, unsigned int port, int state);
+Q_DECL_EXPORT int CALL_CONV SetOutputs(const RcsOutputCmd *cmds, unsigned int count);
+// priority: 0 = signal aspect "Stůj", 1 = other aspects, 2 = plain outputs, 3 = output resets
+Q_DECL_EXPORT int CALL_CONV GetOutputQueueStats(unsigned int priority, RcsOutputQueueStats *stats);
 Q_DECL_EXPORT int CALL_CONV GetInputType(unsigned int module, unsigned int port);
 Q_DECL_EXPORT int CALL_CONV GetOutputType(unsigned int module, unsigned int port);
 
@@ -78,12 +113,36 @@ Q_DECL_EXPORT void CALL_CONV BindAfterStop(StdNotifyEvent f, void *data);
 
 Q_DECL_EXPORT void CALL_CONV BindOnError(StdErrorEvent f, void *data);
 Q_DECL_EXPORT void CALL_CONV BindOnLog(StdLogEvent f, void *data);
+Q_DECL_EXPORT void CALL_CONV BindOnLogBatch(StdLogBatchEvent f, void *data);
 Q_DECL_EXPORT void CALL_CONV BindOnScanned(StdNotifyEvent f, void *data);
 
 Q_DECL_EXPORT void CALL_CONV BindOnInputChanged(StdModuleChangeEvent f, void *data);
 Q_DECL_EXPORT void CALL_CONV BindOnOutputChanged(StdModuleChangeEvent f, void *data);
 Q_DECL_EXPORT void CALL_CONV BindOnModuleChanged(StdModuleChangeEvent f, void *data);
 
+Q_DECL_EXPORT void CALL_CONV BindOnSignalsResetProgress(StdProgressEvent f, void *data);
+
+// Subscriptions: any number of subscribers per event, Bind* sets single slot of hJOPserver.
+// eventMask: bit 0-8 beforeOpen, afterOpen, beforeClose, afterClose, beforeStart, afterStart,
+// beforeStop, afterStop, onScanned; bit 10-12 onInputChanged, onOutputChanged, onModuleChanged.
+// Subscribe* returns handle (0 = invalid arguments), module range is inclusive.
+Q_DECL_EXPORT unsigned int CALL_CONV SubscribeNotify(unsigned int eventMask, StdNotifyEvent f,
+                                                     void *data);
+Q_DECL_EXPORT unsigned int CALL_CONV SubscribeModuleChange(unsigned int eventMask,
+                                                           unsigned int firstModule,
+                                                           unsigned int lastModule,
+                                                           StdModuleChangeEvent f, void *data);
+Q_DECL_EXPORT unsigned int CALL_CONV SubscribeError(StdErrorEvent f, void *data);
+Q_DECL_EXPORT unsigned int CALL_CONV SubscribeSignalsResetProgress(StdProgressEvent f, void *data);
+// Unsubscribe waits for callback of the subscription running in another thread; no callback is
+// called after it returns. It could be called from the callback itself, but not from code the
+// running callback waits for.
+Q_DECL_EXPORT int CALL_CONV Unsubscribe(unsigned int handle);
+
+// Events are delivered asynchronously in thread which loaded the library by default (requires
+// its message loop). direct = true: events are called directly in library's XN thread.
+Q_DECL_EXPORT void CALL_CONV SetEventsDelivery(bool direct);
+
 
 } // extern C
 
@@ -0,0 +1,103 @@
+#include "log-model.h"
+
+namespace RcsXn {
+
+LogModel::LogModel(QObject *parent) : QAbstractTableModel(parent) {
+	m_ring.resize(MAX_LOGTABLE_ITEMS);
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : static_cast<int>(m_active ? m_count : 0);
+}
+
+int LogModel::columnCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : ColCount;
+}
+
+const LogRecord &LogModel::record(size_t row) const {
+	return m_ring[(m_first + row) % m_ring.size()];
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+	if ((!index.isValid()) || (static_cast<size_t>(index.row()) >= m_count))
+		return QVariant();
+	const LogRecord &record = this->record(static_cast<size_t>(index.row()));
+
+	if (role == Qt::DisplayRole) {
+		if (index.column() == ColTime)
+			return record.time.toString("hh:mm:ss,zzz");
+		if (index.column() == ColLoglevel)
+			return loglevelName(record.loglevel);
+		if (index.column() == ColMessage)
+			return record.msg;
+	} else if ((role == Qt::ToolTipRole) && (index.column() == ColMessage)) {
+		return record.msg;
+	} else if (role == Qt::BackgroundRole) {
+		if (record.loglevel == RcsXnLogLevel::llError)
+			return LOGC_ERROR;
+		if (record.loglevel == RcsXnLogLevel::llWarning)
+			return LOGC_WARN;
+		if (record.msg.startsWith("GET:"))
+			return LOGC_GET;
+		if (record.msg.startsWith("PUT:"))
+			return LOGC_PUT;
+	}
+
+	return QVariant();
+}
+
+void LogModel::add(RcsXnLogLevel loglevel, const QString &msg, const QTime &time) {
+	const bool full = (m_count == m_ring.size());
+
+	if (full && m_active) {
+		this->beginRemoveRows(QModelIndex(), 0, 0);
+		m_first = (m_first + 1) % m_ring.size();
+		m_count--;
+		this->endRemoveRows();
+	} else if (full) {
+		m_first = (m_first + 1) % m_ring.size();
+		m_count--;
+	}
+
+	const int row = static_cast<int>(m_count);
+	if (m_active)
+		this->beginInsertRows(QModelIndex(), row, row);
+	LogRecord &record = m_ring[(m_first + m_count) % m_ring.size()];
+	record.time = time;
+	record.loglevel = loglevel;
+	record.msg = msg;
+	m_count++;
+	if (m_active)
+		this->endInsertRows();
+}
+
+void LogModel::clear() {
+	this->beginResetModel();
+	for (LogRecord &record : m_ring)
+		record.msg.clear();
+	m_first = m_count = 0;
+	this->endResetModel();
+}
+
+void LogModel::setActive(bool active) {
+	if (active == m_active)
+		return;
+	this->beginResetModel();
+	m_active = active;
+	this->endResetModel();
+}
+
+QString LogModel::loglevelName(RcsXnLogLevel loglevel) {
+	switch (loglevel) {
+	case RcsXnLogLevel::llNo: return "Nic";
+	case RcsXnLogLevel::llError: return "Chyba";
+	case RcsXnLogLevel::llWarning: return "Varování";
+	case RcsXnLogLevel::llInfo: return "Info";
+	case RcsXnLogLevel::llCommands: return "Příkaz";
+	case RcsXnLogLevel::llRawCommands: return "Data";
+	case RcsXnLogLevel::llDebug: return "Debug";
+	}
+	return "";
+}
+
+} // namespace RcsXn
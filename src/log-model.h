@@ -0,0 +1,69 @@
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+/* Log table of the configuration dialog. Log records are stored in a
+ * fixed-capacity ring buffer (oldest records are overwritten) and displayed
+ * via QAbstractTableModel, so only visible rows are ever rendered. While the
+ * model is inactive (dialog hidden), records are just stored into the ring
+ * and no signals are emitted to views.
+ */
+
+#include <QAbstractTableModel>
+#include <QColor>
+#include <QString>
+#include <QTime>
+#include <vector>
+
+#include "common.h"
+
+namespace RcsXn {
+
+constexpr size_t MAX_LOGTABLE_ITEMS = 1000;
+
+const QColor LOGC_ERROR = QColor(0xFF, 0xAA, 0xAA);
+const QColor LOGC_WARN = QColor(0xFF, 0xFF, 0xAA);
+const QColor LOGC_DONE = QColor(0xAA, 0xFF, 0xAA);
+const QColor LOGC_GET = QColor(0xE0, 0xE0, 0xFF);
+const QColor LOGC_PUT = QColor(0xE0, 0xFF, 0xE0);
+
+struct LogRecord {
+	QTime time;
+	RcsXnLogLevel loglevel;
+	QString msg;
+};
+
+class LogModel : public QAbstractTableModel {
+	Q_OBJECT
+
+public:
+	enum Column {
+		ColTime = 0,
+		ColLoglevel = 1,
+		ColMessage = 2,
+		ColCount = 3,
+	};
+
+	explicit LogModel(QObject *parent = nullptr);
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+	void add(RcsXnLogLevel loglevel, const QString &msg, const QTime &time = QTime::currentTime());
+	void clear();
+	void setActive(bool active);
+
+	static QString loglevelName(RcsXnLogLevel);
+
+private:
+	std::vector<LogRecord> m_ring;
+	size_t m_first = 0; // index of oldest record
+	size_t m_count = 0;
+	bool m_active = false;
+
+	const LogRecord &record(size_t row) const;
+};
+
+} // namespace RcsXn
+
+#endif // LOG_MODEL_H
@@ -0,0 +1,82 @@
+#include "log-sink.h"
+
+namespace RcsXn {
+
+AsyncLogSink::~AsyncLogSink() {
+	if (this->m_thread.joinable())
+		this->m_thread.detach();
+}
+
+void AsyncLogSink::start(size_t capacity, LogDropPolicy policy, Deliver deliver) {
+	this->stop();
+
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_capacity = (capacity > 0) ? capacity : LOG_SINK_DEFAULT_CAPACITY;
+		this->m_policy = policy;
+		this->m_deliver = std::move(deliver);
+		this->m_stopping = false;
+	}
+
+	this->m_running = true;
+	this->m_thread = std::thread([this]() { this->run(); });
+}
+
+void AsyncLogSink::stop() {
+	if (!this->m_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_stopping = true;
+	}
+	this->m_cv.notify_one();
+	this->m_thread.join();
+	this->m_running = false;
+}
+
+void AsyncLogSink::setDeliver(Deliver deliver) {
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_deliver = std::move(deliver);
+}
+
+void AsyncLogSink::push(int loglevel, const QString &msg) {
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		if (this->m_queue.size() >= this->m_capacity) {
+			this->m_dropped++;
+			if (this->m_policy == LogDropPolicy::dropNewest)
+				return;
+			this->m_queue.pop_front();
+		}
+		this->m_queue.push_back({loglevel, msg});
+	}
+	this->m_cv.notify_one();
+}
+
+void AsyncLogSink::run() {
+	std::vector<QueuedLog> batch;
+	Deliver deliver;
+
+	while (true) {
+		bool stopping;
+		{
+			std::unique_lock<std::mutex> lock(this->m_mutex);
+			this->m_cv.wait(lock, [this]() { return this->m_stopping || !this->m_queue.empty(); });
+			batch.assign(std::make_move_iterator(this->m_queue.begin()),
+			             std::make_move_iterator(this->m_queue.end()));
+			this->m_queue.clear();
+			stopping = this->m_stopping;
+			deliver = this->m_deliver;
+		}
+
+		if ((!batch.empty()) && (deliver))
+			deliver(batch);
+		batch.clear();
+
+		if (stopping)
+			return;
+	}
+}
+
+} // namespace RcsXn
@@ -0,0 +1,69 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+/* Asynchronous delivery of log messages to the parent application. Messages
+ * are put into a bounded multi-producer queue and delivered by a dedicated
+ * thread, so slow logging in the parent application does not block XpressNET
+ * processing. When the queue is full, messages are dropped according to
+ * LogDropPolicy and counted.
+ *
+ * Owner stops the sink explicitly (RcsXn does it in XN thread when Shutdown()
+ * is called). Destructor never joins the thread, because it could run while
+ * FreeLibrary holds the loader lock; running thread is detached.
+ */
+
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RcsXn {
+
+constexpr size_t LOG_SINK_DEFAULT_CAPACITY = 4096;
+
+enum class LogDropPolicy {
+	dropNewest = 0,
+	dropOldest = 1,
+};
+
+struct QueuedLog {
+	int loglevel;
+	QString msg;
+};
+
+class AsyncLogSink {
+public:
+	using Deliver = std::function<void(const std::vector<QueuedLog> &)>;
+
+	~AsyncLogSink();
+
+	void start(size_t capacity, LogDropPolicy policy, Deliver deliver);
+	void stop(); // delivers all queued messages
+	void setDeliver(Deliver deliver); // used from next batch on
+	bool running() const { return this->m_running; }
+	void push(int loglevel, const QString &msg);
+	uint64_t dropped() const { return this->m_dropped; }
+
+private:
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<QueuedLog> m_queue;
+	size_t m_capacity = LOG_SINK_DEFAULT_CAPACITY;
+	LogDropPolicy m_policy = LogDropPolicy::dropNewest;
+	Deliver m_deliver;
+	bool m_stopping = false;
+	std::atomic<bool> m_running {false};
+	std::atomic<uint64_t> m_dropped {0};
+
+	void run();
+};
+
+} // namespace RcsXn
+
+#endif // LOG_SINK_H
@@ -0,0 +1,156 @@
+#include "output-queue.h"
+
+namespace RcsXn {
+
+void OutputQueue::push(OutputPriority priority, uint16_t portAddr, bool state, qint64 now,
+                       qint64 coalesceWindow) {
+	const size_t i = static_cast<size_t>(priority);
+
+	// Older conflicting commands in lower priority would be sent after this one
+	if (portAddr < IO_COUNT) {
+		const uint16_t secondPort = static_cast<uint16_t>(portAddr ^ 1);
+		for (size_t j = i+1; j < OUTPUT_PRIORITIES_COUNT; j++) {
+			if (this->m_portQueued[portAddr][j] > 0)
+				this->dropPort(j, portAddr, false);
+			if (this->m_portQueuedOn[secondPort][j] > 0)
+				this->dropPort(j, secondPort, true);
+		}
+	}
+
+	if ((coalesceWindow > 0) && (portAddr < IO_COUNT) &&
+	    (this->m_portPriority[portAddr] == static_cast<int8_t>(i))) {
+		QueuedOutput &queued = this->m_queues[i][this->m_portSeq[portAddr] - this->m_popped[i]];
+		if (now - queued.enqueued <= coalesceWindow) {
+			if (queued.state != state) {
+				if (state)
+					this->m_portQueuedOn[portAddr][i]++;
+				else
+					this->m_portQueuedOn[portAddr][i]--;
+			}
+			queued.state = state;
+			this->m_stats[i].superseded++;
+			return;
+		}
+	}
+
+	if (portAddr < IO_COUNT) {
+		this->m_portPriority[portAddr] = static_cast<int8_t>(i);
+		this->m_portSeq[portAddr] = this->m_popped[i] + this->m_queues[i].size();
+		this->m_portQueued[portAddr][i]++;
+		if (state)
+			this->m_portQueuedOn[portAddr][i]++;
+	}
+	this->m_queues[i].push_back({portAddr, state, now});
+	this->m_stats[i].depth++;
+	this->m_size++;
+}
+
+void OutputQueue::dropPort(size_t priority, uint16_t portAddr, bool activationsOnly) {
+	std::deque<QueuedOutput> &queue = this->m_queues[priority];
+	uint32_t &count = this->m_portQueued[portAddr][priority];
+	uint32_t &countOn = this->m_portQueuedOn[portAddr][priority];
+	for (size_t k = 0; (k < queue.size()) && ((activationsOnly) ? countOn : count) > 0; k++) {
+		QueuedOutput &queued = queue[k];
+		if ((queued.dropped) || (queued.portAddr != portAddr))
+			continue;
+		if ((activationsOnly) && (!queued.state))
+			continue;
+		queued.dropped = true;
+		if ((this->m_portPriority[portAddr] == static_cast<int8_t>(priority)) &&
+		    (this->m_portSeq[portAddr] == this->m_popped[priority] + k))
+			this->m_portPriority[portAddr] = -1;
+		count--;
+		if (queued.state)
+			countOn--;
+		this->m_stats[priority].depth--;
+		this->m_stats[priority].superseded++;
+		this->m_size--;
+	}
+	this->purge(priority);
+}
+
+void OutputQueue::purge(size_t priority) {
+	// Front of each queue is never dropped command (select & pop rely on it)
+	std::deque<QueuedOutput> &queue = this->m_queues[priority];
+	while ((!queue.empty()) && (queue.front().dropped)) {
+		queue.pop_front();
+		this->m_popped[priority]++;
+	}
+}
+
+bool OutputQueue::starving(qint64 now) const {
+	for (const std::deque<QueuedOutput> &queue : this->m_queues)
+		if ((!queue.empty()) && (now - queue.front().enqueued >= OUTPUT_MAX_WAIT))
+			return true;
+	return false;
+}
+
+qint64 OutputQueue::nextStarving() const {
+	qint64 next = OUTPUT_NO_DEADLINE;
+	for (const std::deque<QueuedOutput> &queue : this->m_queues)
+		if ((!queue.empty()) &&
+		    ((next == OUTPUT_NO_DEADLINE) || (queue.front().enqueued + OUTPUT_MAX_WAIT < next)))
+			next = queue.front().enqueued + OUTPUT_MAX_WAIT;
+	return next;
+}
+
+size_t OutputQueue::select(qint64 now) const {
+	// Starving command (oldest of them) goes first, otherwise highest priority
+	size_t oldest = OUTPUT_PRIORITIES_COUNT;
+	for (size_t i = 0; i < OUTPUT_PRIORITIES_COUNT; i++) {
+		if ((this->m_queues[i].empty()) || (now - this->m_queues[i].front().enqueued < OUTPUT_MAX_WAIT))
+			continue;
+		if ((oldest == OUTPUT_PRIORITIES_COUNT) ||
+		    (this->m_queues[i].front().enqueued < this->m_queues[oldest].front().enqueued))
+			oldest = i;
+	}
+	if (oldest < OUTPUT_PRIORITIES_COUNT)
+		return oldest;
+
+	for (size_t i = 0; i < OUTPUT_PRIORITIES_COUNT; i++)
+		if (!this->m_queues[i].empty())
+			return i;
+	return OUTPUT_PRIORITIES_COUNT;
+}
+
+QueuedOutput OutputQueue::pop(qint64 now) {
+	const size_t i = this->select(now);
+	const QueuedOutput output = this->m_queues[i].front();
+	if ((output.portAddr < IO_COUNT) &&
+	    (this->m_portPriority[output.portAddr] == static_cast<int8_t>(i)) &&
+	    (this->m_portSeq[output.portAddr] == this->m_popped[i]))
+		this->m_portPriority[output.portAddr] = -1;
+	if (output.portAddr < IO_COUNT) {
+		this->m_portQueued[output.portAddr][i]--;
+		if (output.state)
+			this->m_portQueuedOn[output.portAddr][i]--;
+	}
+	this->m_queues[i].pop_front();
+	this->m_popped[i]++;
+	this->m_size--;
+	this->purge(i);
+
+	OutputQueueStats &stats = this->m_stats[i];
+	stats.depth--;
+	stats.sent++;
+	stats.lastWait = now - output.enqueued;
+	stats.totalWait += stats.lastWait;
+	if (stats.lastWait > stats.maxWait)
+		stats.maxWait = stats.lastWait;
+
+	return output;
+}
+
+void OutputQueue::clear() {
+	for (size_t i = 0; i < OUTPUT_PRIORITIES_COUNT; i++) {
+		this->m_popped[i] += this->m_queues[i].size();
+		this->m_queues[i].clear();
+		this->m_stats[i].depth = 0;
+	}
+	this->m_portPriority.fill(-1);
+	this->m_portQueued.fill({});
+	this->m_portQueuedOn.fill({});
+	this->m_size = 0;
+}
+
+} // namespace RcsXn
@@ -0,0 +1,100 @@
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+
+/* Priority queue of output commands waiting to be handed to the XN library.
+ * Commands of higher priority overtake queued commands of lower priority.
+ * Command waiting longer than OUTPUT_MAX_WAIT is sent regardless of its
+ * priority, so lower classes cannot starve; such command may use one extra
+ * in-flight slot (caller checks starving() on timer, see nextStarving()).
+ * Command for a port with an unsent command of the same priority queued
+ * less than coalesce window ago replaces state of the queued command instead
+ * of being appended (blinking outputs do not flood the bus).
+ * A command never overtakes an older conflicting command: when it is pushed,
+ * queued commands of lower priority for the same port are dropped, and so are
+ * activations of the second port of the accessory pair (portAddr/2; ports of
+ * the pair are mutually exclusive). Deactivations (e.g. pending reset) of the
+ * second port are kept. Commands of higher or same priority are sent before
+ * it anyway.
+ */
+
+#include <QtGlobal>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "common.h"
+
+namespace RcsXn {
+
+enum class OutputPriority {
+	stop = 0, // signal aspect "Stůj"
+	signal = 1, // other signal aspects
+	plain = 2, // plain outputs (turnouts etc.)
+	reset = 3, // reset of output after OUTPUT_ACTIVE_TIME
+};
+
+constexpr size_t OUTPUT_PRIORITIES_COUNT = 4;
+constexpr size_t OUTPUT_MAX_IN_FLIGHT = 2; // commands handed to XN library at once
+constexpr size_t OUTPUT_MAX_IN_FLIGHT_STARVING = OUTPUT_MAX_IN_FLIGHT + 1; // extra slot
+constexpr qint64 OUTPUT_MAX_WAIT = 1000; // ms
+constexpr qint64 OUTPUT_NO_DEADLINE = -1;
+
+struct QueuedOutput {
+	uint16_t portAddr; // 0-2047
+	bool state;
+	qint64 enqueued; // ms
+	bool dropped = false; // superseded by newer conflicting command, skipped by pop
+};
+
+struct OutputQueueStats {
+	size_t depth = 0;
+	uint64_t sent = 0;
+	qint64 lastWait = 0; // ms
+	qint64 maxWait = 0; // ms
+	qint64 totalWait = 0; // ms
+	uint64_t superseded = 0; // commands replaced by newer command for the same port or pair
+};
+
+class OutputQueue {
+public:
+	OutputQueue() {
+		this->m_portPriority.fill(-1);
+		this->m_portQueued.fill({});
+		this->m_portQueuedOn.fill({});
+	}
+
+	void push(OutputPriority priority, uint16_t portAddr, bool state, qint64 now,
+	          qint64 coalesceWindow = 0);
+	QueuedOutput pop(qint64 now); // expects non-empty queue
+	void clear();
+
+	bool empty() const { return this->m_size == 0; }
+	size_t size() const { return this->m_size; }
+	bool starving(qint64 now) const; // any command waits longer than OUTPUT_MAX_WAIT
+	qint64 nextStarving() const; // time the oldest command starts starving or OUTPUT_NO_DEADLINE
+	const OutputQueueStats &stats(OutputPriority priority) const {
+		return this->m_stats[static_cast<size_t>(priority)];
+	}
+
+private:
+	std::array<std::deque<QueuedOutput>, OUTPUT_PRIORITIES_COUNT> m_queues;
+	std::array<OutputQueueStats, OUTPUT_PRIORITIES_COUNT> m_stats;
+	size_t m_size = 0;
+
+	// Queued command of port p is m_queues[prio][m_portSeq[p] - m_popped[prio]]
+	std::array<uint64_t, OUTPUT_PRIORITIES_COUNT> m_popped {};
+	std::array<uint64_t, IO_COUNT> m_portSeq;
+	std::array<int8_t, IO_COUNT> m_portPriority; // -1 = no command of the port in queue
+	// count of queued (not dropped) commands of each port in each priority, all & activations
+	std::array<std::array<uint32_t, OUTPUT_PRIORITIES_COUNT>, IO_COUNT> m_portQueued;
+	std::array<std::array<uint32_t, OUTPUT_PRIORITIES_COUNT>, IO_COUNT> m_portQueuedOn;
+
+	size_t select(qint64 now) const;
+	void dropPort(size_t priority, uint16_t portAddr, bool activationsOnly);
+	void purge(size_t priority); // removes dropped commands from front
+};
+
+} // namespace RcsXn
+
+#endif // OUTPUT_QUEUE_H
@@ -0,0 +1,128 @@
+#ifndef RANGE_CODEC_H
+#define RANGE_CODEC_H
+
+/* Parsing & serialization of module ranges ("1-28,70-92,100") to/from
+ * BitArray. Parser works on views of the input string (no splitting into
+ * lists) and reports all invalid tokens with their positions. Serializer
+ * writes into single preallocated buffer.
+ */
+
+#include <QString>
+#include <QStringView>
+#include <vector>
+
+#include "bit-array.h"
+
+namespace RcsXn {
+
+struct RangeError {
+	size_t position; // index of first character of the token in parsed string
+	QString token;
+};
+
+class RangeCodec {
+public:
+	// Valid ranges are stored to 'result' even if some tokens are invalid
+	template <std::size_t N>
+	static std::vector<RangeError> parse(QStringView str, BitArray<N> &result);
+
+	template <std::size_t N>
+	static QString serialize(const BitArray<N> &source, const QString &separator);
+
+private:
+	static constexpr size_t NUMBER_MAX_DIGITS = 9;
+	static constexpr size_t NUMBER_MAX_RUN_DIGITS = 5; // serialized addresses < 100000
+
+	static bool parseNumber(QStringView str, size_t &result) {
+		str = str.trimmed();
+		if ((str.isEmpty()) || (static_cast<size_t>(str.size()) > NUMBER_MAX_DIGITS))
+			return false;
+		result = 0;
+		for (const QChar c : str) {
+			if ((c < QLatin1Char('0')) || (c > QLatin1Char('9')))
+				return false;
+			result = 10*result + static_cast<size_t>(c.unicode() - u'0');
+		}
+		return true;
+	}
+
+	static void appendNumber(QString &output, size_t number) {
+		QChar digits[20];
+		size_t first = 20;
+		do {
+			digits[--first] = QChar(static_cast<char16_t>(u'0' + number%10));
+			number /= 10;
+		} while (number > 0);
+		output.append(digits + first, static_cast<int>(20 - first));
+	}
+};
+
+template <std::size_t N>
+std::vector<RangeError> RangeCodec::parse(QStringView str, BitArray<N> &result) {
+	std::vector<RangeError> errors;
+	result.reset();
+
+	const size_t length = static_cast<size_t>(str.size());
+	size_t start = 0;
+	while (start < length) {
+		size_t end = start;
+		while ((end < length) && (str[end] != QLatin1Char(',')))
+			end++;
+
+		const QStringView token = str.mid(start, end-start);
+		if (!token.trimmed().isEmpty()) {
+			const size_t tokenLength = static_cast<size_t>(token.size());
+			size_t dash = 0;
+			while ((dash < tokenLength) && (token[dash] != QLatin1Char('-')))
+				dash++;
+
+			size_t left, right;
+			bool ok;
+			if (dash == tokenLength) {
+				ok = (parseNumber(token, left)) && (left < N);
+				right = left;
+			} else {
+				ok = (parseNumber(token.left(dash), left)) &&
+				     (parseNumber(token.mid(dash+1), right)) && (left <= right) && (right < N);
+			}
+
+			if (ok)
+				result.setRange(left, right);
+			else
+				errors.push_back({start, token.trimmed().toString()});
+		}
+
+		start = end+1;
+	}
+
+	return errors;
+}
+
+template <std::size_t N>
+QString RangeCodec::serialize(const BitArray<N> &source, const QString &separator) {
+	size_t runs = 0;
+	for (size_t start = source.findNext(true, 0); start < N;
+	     start = source.findNext(true, source.findNext(false, start)))
+		runs++;
+
+	QString output;
+	const size_t maxRunLength = 2*NUMBER_MAX_RUN_DIGITS + 1 + static_cast<size_t>(separator.size());
+	output.reserve(static_cast<int>(runs * maxRunLength));
+
+	size_t start = source.findNext(true, 0);
+	while (start < N) {
+		const size_t end = source.findNext(false, start);
+		appendNumber(output, start);
+		if (end > start+1) {
+			output.append(QLatin1Char('-'));
+			appendNumber(output, end-1);
+		}
+		output.append(separator);
+		start = source.findNext(true, end);
+	}
+	return output;
+}
+
+} // namespace RcsXn
+
+#endif // RANGE_CODEC_H
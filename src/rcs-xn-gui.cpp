@@ -1,15 +1,30 @@
 #include <QMessageBox>
 #include <QSerialPortInfo>
 
-#include "rcs-xn.h"
+#include "rcs-xn-gui.h"
 #include "q-tree-num-widget-item.h"
 
-/* Implementations of GUI functions from rcs-xn.h */
-
 namespace RcsXn {
 
-void RcsXn::guiInit() {
-	form.ui.cb_loglevel->setCurrentIndex(static_cast<int>(this->loglevel));
+RcsXnGui::RcsXnGui(QObject *parent)
+	: QObject(parent),
+	  modules_model(rx.modules_in, [](const std::function<void()> &f) { xn_thread.call(f); }),
+	  f_signal_edit(sig_templates) {
+	// Created during library loading -> XN thread must not be used here (defaults are shown)
+	this->guiInit();
+	Settings defaults;
+	this->fillConnectionsCbs(defaults);
+	this->form.ui.tw_xn_log->setColumnWidth(LogModel::ColTime, 90);
+
+	xn_thread.setObserver(this); // log table is present now
+}
+
+RcsXnGui::~RcsXnGui() {
+	xn_thread.setObserver(nullptr);
+}
+
+void RcsXnGui::guiInit() {
+	form.ui.cb_loglevel->setCurrentIndex(static_cast<int>(RcsXnLogLevel::llInfo)); // RcsXn default
 	QObject::connect(form.ui.cb_loglevel, SIGNAL(currentIndexChanged(int)), this,
 	                 SLOT(cb_loglevel_changed(int)));
 	QObject::connect(form.ui.cb_interface_type, SIGNAL(currentIndexChanged(int)), this,
@@ -26,6 +41,9 @@ void RcsXn::guiInit() {
 					 SLOT(chb_general_config_changed(int)));
 	QObject::connect(form.ui.cb_addr_range, SIGNAL(currentIndexChanged(int)), this,
 	                 SLOT(chb_general_config_changed(int)));
+	QObject::connect(form.ui.chb_scan_inputs, SIGNAL(stateChanged(int)), this,
+	                 SLOT(chb_scan_inputs_changed(int)));
+	// chb_scan_inputs is unchecked by default same as RcsXn::autoActivateInputs
 
 	QObject::connect(form.ui.b_serial_refresh, SIGNAL(released()), this,
 	                 SLOT(b_serial_refresh_handle()));
@@ -37,8 +55,15 @@ void RcsXn::guiInit() {
 	QObject::connect(form.ui.b_signal_remove, SIGNAL(released()), this,
 	                 SLOT(b_signal_remove_handle()));
 
-	QObject::connect(form.ui.tw_xn_log, SIGNAL(itemDoubleClicked(QTreeWidgetItem*,int)), this,
-	                 SLOT(tw_log_double_clicked(QTreeWidgetItem*,int)));
+	// Before models are activated, so pending changes are flushed into inactive models
+	QObject::connect(&this->form, &MainWindow::visibilityChanged, this,
+	                 &RcsXnGui::viewVisibilityChanged);
+
+	form.ui.tw_xn_log->setModel(&this->log_model);
+	QObject::connect(form.ui.tw_xn_log, SIGNAL(doubleClicked(QModelIndex)), this,
+	                 SLOT(tw_log_double_clicked(QModelIndex)));
+	QObject::connect(&this->form, &MainWindow::visibilityChanged, &this->log_model,
+	                 &LogModel::setActive);
 	QObject::connect(form.ui.tw_signals, SIGNAL(itemDoubleClicked(QTreeWidgetItem*,int)), this,
 	                 SLOT(tw_signals_dbl_click(QTreeWidgetItem*,int)));
 	QObject::connect(form.ui.tw_signals, SIGNAL(itemSelectionChanged()), this,
@@ -46,8 +71,11 @@ void RcsXn::guiInit() {
 
 	QObject::connect(&this->f_module_edit, SIGNAL(accepted()), this,
 	                 SLOT(f_module_edit_accepted()));
-	QObject::connect(form.ui.tw_input_modules, SIGNAL(itemDoubleClicked(QTreeWidgetItem*,int)), this,
-	                 SLOT(tw_input_modules_dbl_click(QTreeWidgetItem*,int)));
+	form.ui.tw_input_modules->setModel(&this->modules_model);
+	QObject::connect(&this->form, &MainWindow::visibilityChanged, &this->modules_model,
+	                 &InputModulesModel::setActive);
+	QObject::connect(form.ui.tw_input_modules, SIGNAL(doubleClicked(QModelIndex)), this,
+	                 SLOT(tw_input_modules_dbl_click(QModelIndex)));
 
 	QObject::connect(form.ui.b_dcc_on, SIGNAL(released()), this, SLOT(b_dcc_on_handle()));
 	QObject::connect(form.ui.b_dcc_off, SIGNAL(released()), this, SLOT(b_dcc_off_handle()));
@@ -63,35 +91,50 @@ void RcsXn::guiInit() {
 	form.setWindowFlags(Qt::Dialog);
 }
 
-void RcsXn::cb_loglevel_changed(int index) { this->setLogLevel(static_cast<RcsXnLogLevel>(index)); }
+void RcsXnGui::cb_loglevel_changed(int index) {
+	const auto loglevel = static_cast<RcsXnLogLevel>(index);
+	xn_thread.call([loglevel]() { rx.setLogLevel(loglevel); });
+}
+
+void RcsXnGui::cb_interface_type_changed(int arg) {
+	if (this->gui_config_changing)
+		return; // fillConnectionsCbs fills port itself
 
-void RcsXn::cb_interface_type_changed(int arg) {
 	this->cb_connections_changed(arg);
-	if ((s["XN"]["port"].toString() == "auto") && (form.ui.cb_interface_type->currentText() != "uLI"))
-		s["XN"]["port"] = "";
-	this->fillPortCb();
+	const bool uLI = (form.ui.cb_interface_type->currentText() == "uLI");
+	const QString port = xn_thread.call([uLI]() {
+		if ((rx.s["XN"]["port"].toString() == "auto") && (!uLI))
+			rx.s["XN"]["port"] = "";
+		return rx.s["XN"]["port"].toString();
+	});
+	this->fillPortCb(port);
 }
 
-void RcsXn::cb_connections_changed(int) {
+void RcsXnGui::cb_connections_changed(int) {
 	if (this->gui_config_changing)
 		return;
 
-	s["XN"]["interface"] = form.ui.cb_interface_type->currentText();
-	s["XN"]["baudrate"] = form.ui.cb_serial_speed->currentText().toInt();
-	s["XN"]["flowcontrol"] = form.ui.cb_serial_flowcontrol->currentIndex();
-
+	const QString iface = form.ui.cb_interface_type->currentText();
+	const int baudrate = form.ui.cb_serial_speed->currentText().toInt();
+	const int flowcontrol = form.ui.cb_serial_flowcontrol->currentIndex();
 	const QString port = form.ui.cb_serial_port->currentText();
-	s["XN"]["port"] = (port.startsWith("Auto")) ? "auto" : port;
+
+	xn_thread.call([&]() {
+		rx.s["XN"]["interface"] = iface;
+		rx.s["XN"]["baudrate"] = baudrate;
+		rx.s["XN"]["flowcontrol"] = flowcontrol;
+		rx.s["XN"]["port"] = (port.startsWith("Auto")) ? "auto" : port;
+	});
 }
 
-void RcsXn::fillConnectionsCbs() {
+void RcsXnGui::fillConnectionsCbs(Settings &s) {
 	this->gui_config_changing = true;
 
 	// Interface type
 	form.ui.cb_interface_type->setCurrentText(s["XN"]["interface"].toString());
 
 	// Port
-	this->fillPortCb();
+	this->fillPortCb(s["XN"]["port"].toString());
 	this->gui_config_changing = true;
 
 	// Speed
@@ -113,7 +156,11 @@ void RcsXn::fillConnectionsCbs() {
 	this->gui_config_changing = false;
 }
 
-void RcsXn::fillPortCb() {
+QString RcsXnGui::configuredPort() const {
+	return xn_thread.call([]() { return rx.s["XN"]["port"].toString(); });
+}
+
+void RcsXnGui::fillPortCb(const QString &configuredPort) {
 	this->gui_config_changing = true;
 
 	form.ui.cb_serial_port->clear();
@@ -122,7 +169,7 @@ void RcsXn::fillPortCb() {
 
 	if (form.ui.cb_interface_type->currentText() == "uLI") {
 		form.ui.cb_serial_port->addItem("Automaticky detekovat port uLI");
-		if (s["XN"]["port"].toString() == "auto") {
+		if (configuredPort == "auto") {
 			is_item = true;
 			form.ui.cb_serial_port->setCurrentIndex(0);
 		}
@@ -131,13 +178,13 @@ void RcsXn::fillPortCb() {
 	const auto& ports = QSerialPortInfo::availablePorts();
 	for (const QSerialPortInfo &port : ports) {
 		form.ui.cb_serial_port->addItem(port.portName());
-		if (port.portName() == s["XN"]["port"].toString())
+		if (port.portName() == configuredPort)
 			is_item = true;
 	}
 
-	if (s["XN"]["port"].toString() != "auto") {
+	if (configuredPort != "auto") {
 		if (is_item)
-			form.ui.cb_serial_port->setCurrentText(s["XN"]["port"].toString());
+			form.ui.cb_serial_port->setCurrentText(configuredPort);
 		else
 			form.ui.cb_serial_port->setCurrentIndex(-1);
 	}
@@ -145,9 +192,13 @@ void RcsXn::fillPortCb() {
 	this->gui_config_changing = false;
 }
 
-void RcsXn::b_serial_refresh_handle() { this->fillPortCb(); }
+void RcsXnGui::b_serial_refresh_handle() { this->fillPortCb(this->configuredPort()); }
 
-void RcsXn::guiOnOpen() {
+void RcsXnGui::onOpen() {
+	this->inGui([this]() { this->guiOnOpen(); });
+}
+
+void RcsXnGui::guiOnOpen() {
 	form.ui.cb_interface_type->setEnabled(false);
 	form.ui.cb_serial_port->setEnabled(false);
 	form.ui.cb_serial_speed->setEnabled(false);
@@ -164,7 +215,11 @@ void RcsXn::guiOnOpen() {
 	this->fillActiveOutputs();
 }
 
-void RcsXn::guiOnClose() {
+void RcsXnGui::onClose() {
+	this->inGui([this]() { this->guiOnClose(); });
+}
+
+void RcsXnGui::guiOnClose() {
 	form.ui.cb_interface_type->setEnabled(true);
 	form.ui.cb_serial_port->setEnabled(true);
 	form.ui.cb_serial_speed->setEnabled(true);
@@ -181,22 +236,22 @@ void RcsXn::guiOnClose() {
 	widgetSetColor(*form.ui.l_dcc_state, Qt::black);
 }
 
-void RcsXn::b_active_outputs_load_handle() {
+void RcsXnGui::b_active_outputs_load_handle() {
 	QApplication::setOverrideCursor(Qt::WaitCursor);
 	this->fillActiveOutputs();
-	form.ui.te_binary_outputs->setText(getActiveStr(this->binary, ",\n"));
+	form.ui.te_binary_outputs->setText(this->binaryOutputsStr());
 	QApplication::restoreOverrideCursor();
 	QMessageBox::information(&(this->form), "Ok", "Načteno.", QMessageBox::Ok);
 }
 
-void RcsXn::b_active_outputs_save_handle() {
+void RcsXnGui::b_active_outputs_save_handle() {
 	QApplication::setOverrideCursor(Qt::WaitCursor);
 
 	try {
-		this->loadActiveIO("", form.ui.te_active_outputs->toPlainText().replace("\n", ","));
-		this->parseModules(form.ui.te_binary_outputs->toPlainText().replace("\n", ","), this->binary, true);
-		this->saveConfig();
-		form.ui.te_binary_outputs->setText(getActiveStr(this->binary, ",\n"));
+		const QString outputs = form.ui.te_active_outputs->toPlainText().replace("\n", ",");
+		const QString binary = form.ui.te_binary_outputs->toPlainText().replace("\n", ",");
+		xn_thread.call([&outputs, &binary]() { rx.setActiveIO(outputs, binary); });
+		form.ui.te_binary_outputs->setText(this->binaryOutputsStr());
 		QApplication::restoreOverrideCursor();
 		QMessageBox::information(&(this->form), "Ok", "Uloženo.", QMessageBox::Ok);
 	} catch (const EInvalidRange &e) {
@@ -212,21 +267,27 @@ void RcsXn::b_active_outputs_save_handle() {
 	}
 }
 
-void RcsXn::fillActiveOutputs() {
-	form.ui.te_active_outputs->setText(getActiveStr(this->user_active_out, ",\n"));
+void RcsXnGui::fillActiveOutputs() {
+	form.ui.te_active_outputs->setText(
+		xn_thread.call([]() { return RangeCodec::serialize(rx.user_active_out, ",\n"); })
+	);
 }
 
-void RcsXn::tw_log_double_clicked(QTreeWidgetItem *item, int column) {
-	(void)item;
-	(void)column;
-	this->form.ui.tw_xn_log->clear();
+QString RcsXnGui::binaryOutputsStr() const {
+	return xn_thread.call([]() { return RangeCodec::serialize(rx.binary, ",\n"); });
+}
+
+void RcsXnGui::tw_log_double_clicked(const QModelIndex &index) {
+	(void)index;
+	this->log_model.clear();
 }
 
-void RcsXn::b_signal_add_handle() {
-	f_signal_edit.open([this](XnSignal signal) { this->newSignal(signal); }, this->sigTemplates);
+void RcsXnGui::b_signal_add_handle() {
+	this->sig_templates = xn_thread.call([]() { return rx.sigTemplates; });
+	f_signal_edit.open([this](XnSignal signal) { this->newSignal(signal); }, this->sig_templates);
 }
 
-void RcsXn::b_signal_remove_handle() {
+void RcsXnGui::b_signal_remove_handle() {
 	QMessageBox::StandardButton reply;
 	reply = QMessageBox::question(&(this->form), "Smazat?", "Skutečně smazat vybraná návěstidla?",
                                   QMessageBox::Yes|QMessageBox::No);
@@ -236,29 +297,28 @@ void RcsXn::b_signal_remove_handle() {
 	QApplication::setOverrideCursor(Qt::WaitCursor);
 
 	for (const QTreeWidgetItem *item : form.ui.tw_signals->selectedItems()) {
-		unsigned int hJOPaddr = item->text(0).toUInt();
-		this->sig.erase(hJOPaddr);
+		const unsigned int hJOPaddr = item->text(0).toUInt();
+		xn_thread.call([hJOPaddr]() { rx.removeSignal(hJOPaddr); });
 
 		// this is slow, but I found no other way :(
 		for (int i = 0; i < form.ui.tw_signals->topLevelItemCount(); ++i)
 			if (form.ui.tw_signals->topLevelItem(i) == item)
 				delete form.ui.tw_signals->takeTopLevelItem(i);
 	}
-	this->saveConfig();
 
 	QApplication::restoreOverrideCursor();
 }
 
-void RcsXn::fillSignals() {
+void RcsXnGui::fillSignals(const SigStorage &sigs) {
 	form.ui.tw_signals->setSortingEnabled(false);
 	form.ui.tw_signals->clear();
-	for (const auto &signal_tuple : this->sig)
+	for (const auto &signal_tuple : sigs)
 		this->guiAddSignal(signal_tuple.second);
 	form.ui.tw_signals->setSortingEnabled(true);
 	form.ui.tw_signals->sortByColumn(0, Qt::SortOrder::AscendingOrder);
 }
 
-void RcsXn::guiAddSignal(const XnSignal &signal) {
+void RcsXnGui::guiAddSignal(const XnSignal &signal) {
 	auto *item = new FirstNumTreeWidgetItem(form.ui.tw_signals);
 	item->setText(0, QString::number(signal.hJOPaddr));
 	item->setText(1, signal.outputRange());
@@ -266,75 +326,88 @@ void RcsXn::guiAddSignal(const XnSignal &signal) {
 	form.ui.tw_signals->addTopLevelItem(item);
 }
 
-void RcsXn::newSignal(XnSignal signal) {
-	if (this->sig.find(signal.hJOPaddr) != this->sig.end())
-		throw QStrException("Návěstidlo s touto hJOP adresou je již definováno!");
-	this->sig.emplace(signal.hJOPaddr, signal);
+void RcsXnGui::newSignal(XnSignal signal) {
+	xn_thread.call([this, &signal]() {
+		rx.sigTemplates = this->sig_templates;
+		rx.addSignal(signal);
+	});
 	this->guiAddSignal(signal);
-	this->saveConfig();
 }
 
-void RcsXn::editedSignal(XnSignal signal) {
-	if ((signal.hJOPaddr != this->current_editing_signal) &&
-	    (this->sig.find(signal.hJOPaddr) != this->sig.end()))
-		throw QStrException("Návěstidlo s touto hJOP adresou je již definováno!");
-	if (this->sig.find(this->current_editing_signal) != this->sig.end()) {
-		this->sig.erase(this->current_editing_signal);
-		for (int i = 0; i < form.ui.tw_signals->topLevelItemCount(); ++i)
-			if (form.ui.tw_signals->topLevelItem(i)->text(0).toUInt() ==
-			    this->current_editing_signal)
-				delete form.ui.tw_signals->takeTopLevelItem(i);
-	}
-	this->sig.emplace(signal.hJOPaddr, signal);
+void RcsXnGui::editedSignal(XnSignal signal) {
+	const unsigned int hJOPaddr = this->current_editing_signal;
+	xn_thread.call([this, hJOPaddr, &signal]() {
+		rx.sigTemplates = this->sig_templates;
+		rx.replaceSignal(hJOPaddr, signal);
+	});
+	for (int i = 0; i < form.ui.tw_signals->topLevelItemCount(); ++i)
+		if (form.ui.tw_signals->topLevelItem(i)->text(0).toUInt() == this->current_editing_signal)
+			delete form.ui.tw_signals->takeTopLevelItem(i);
 	this->guiAddSignal(signal);
-	this->saveConfig();
 }
 
-void RcsXn::tw_signals_dbl_click(QTreeWidgetItem *item, int column) {
+void RcsXnGui::tw_signals_dbl_click(QTreeWidgetItem *item, int column) {
 	(void)column;
-	this->current_editing_signal = item->text(0).toUInt();
-	f_signal_edit.open(this->sig[this->current_editing_signal],
-	                   [this](XnSignal signal) { this->editedSignal(signal); }, this->sigTemplates);
+	const unsigned int hJOPaddr = item->text(0).toUInt();
+	this->current_editing_signal = hJOPaddr;
+	XnSignal signal;
+	xn_thread.call([this, hJOPaddr, &signal]() {
+		signal = rx.sig[hJOPaddr];
+		this->sig_templates = rx.sigTemplates;
+	});
+	f_signal_edit.open(signal, [this](XnSignal signal) { this->editedSignal(signal); },
+	                   this->sig_templates);
 }
 
-void RcsXn::tw_signals_selection_changed() {
+void RcsXnGui::tw_signals_selection_changed() {
 	form.ui.b_signal_remove->setEnabled(!form.ui.tw_signals->selectedItems().empty());
 }
 
-void RcsXn::chb_general_config_changed(int) {
+void RcsXnGui::chb_general_config_changed(int) {
 	if (this->gui_config_changing)
 		return;
 
-	s["global"]["resetSignals"] =
-	    (form.ui.chb_reset_signals->checkState() == Qt::CheckState::Checked);
-	s["global"]["disableSetOutputOff"] =
+	const bool resetSignals = (form.ui.chb_reset_signals->checkState() == Qt::CheckState::Checked);
+	const bool disableSetOutputOff =
 		(form.ui.chb_disable_set_output_off->checkState() == Qt::CheckState::Checked);
+	const int addrRange = form.ui.cb_addr_range->currentIndex();
+
+	xn_thread.call([resetSignals, disableSetOutputOff, addrRange]() {
+		rx.s["global"]["resetSignals"] = resetSignals;
+		rx.s["global"]["disableSetOutputOff"] = disableSetOutputOff;
+
+		if (addrRange == 0)
+			rx.s["global"]["addrRange"] = "basic";
+		else if (addrRange == 1)
+			rx.s["global"]["addrRange"] = "lenz";
 
-	if (form.ui.cb_addr_range->currentIndex() == 0)
-		s["global"]["addrRange"] = "basic";
-	else if (form.ui.cb_addr_range->currentIndex() == 1)
-		s["global"]["addrRange"] = "lenz";
+		rx.refreshRuntimeConfig();
+	});
 }
 
-void RcsXn::xn_onDccError(void *, void *) {
+void RcsXnGui::chb_scan_inputs_changed(int) {
+	const bool autoActivate = form.ui.chb_scan_inputs->isChecked();
+	xn_thread.call([autoActivate]() { rx.autoActivateInputs = autoActivate; });
+}
+
+void RcsXnGui::xn_onDccError(void *, void *) {
 	form.ui.b_dcc_on->setEnabled(true);
 	form.ui.b_dcc_off->setEnabled(true);
 	QMessageBox::warning(&(this->form), "Error!",
 	                     "Centrála neodpověděla na příkaz o nastavení DCC!");
 }
 
-void RcsXn::xn_onDccOpenError(void *, void *) {
-	log("No response on 'Set DCC' command!", RcsXnLogLevel::llError);
-	this->close();
-}
-
-void RcsXn::setDcc(Xn::TrkStatus status) {
+void RcsXnGui::setDcc(Xn::TrkStatus status) {
 	try {
-		if (xn.connected())
-			xn.setTrkStatus(
-				status, nullptr,
-				std::make_unique<Xn::Cb>([this](void *s, void *d) { xn_onDccError(s, d); })
-			);
+		xn_thread.call([this, status]() {
+			if (rx.xn.connected())
+				rx.xn.setTrkStatus(
+					status, nullptr,
+					std::make_unique<Xn::Cb>([this](void *s, void *d) {
+						this->inGui([this, s, d]() { this->xn_onDccError(s, d); });
+					})
+				);
+		});
 	} catch (const Xn::QStrException& e) {
 		form.ui.b_dcc_on->setEnabled(true);
 		form.ui.b_dcc_off->setEnabled(true);
@@ -342,98 +415,156 @@ void RcsXn::setDcc(Xn::TrkStatus status) {
 	}
 }
 
-void RcsXn::b_dcc_on_handle() {
+void RcsXnGui::b_dcc_on_handle() {
 	form.ui.b_dcc_on->setEnabled(false);
 	this->setDcc(Xn::TrkStatus::On);
 }
-void RcsXn::b_dcc_off_handle() {
+void RcsXnGui::b_dcc_off_handle() {
 	form.ui.b_dcc_off->setEnabled(false);
 	this->setDcc(Xn::TrkStatus::Off);
 }
 
-void RcsXn::widgetSetColor(QWidget &widget, const QColor &color) {
+void RcsXnGui::widgetSetColor(QWidget &widget, const QColor &color) {
 	QPalette palette = widget.palette();
 	palette.setColor(QPalette::WindowText, color);
 	widget.setPalette(palette);
 }
 
-void RcsXn::twFillInputModules() {
-	form.ui.tw_input_modules->clear();
-
-	for (unsigned addr = 0; addr < IO_IN_MODULES_COUNT; addr++) {
-		auto *item = new FirstNumTreeWidgetItem(form.ui.tw_input_modules);
-		form.ui.tw_input_modules->addTopLevelItem(item);
-		this->twUpdateInputModule(addr);
-	}
-
-	for (int i = 0; i < form.ui.tw_input_modules->columnCount(); ++i)
-		form.ui.tw_input_modules->resizeColumnToContents(i);
+void RcsXnGui::tw_input_modules_dbl_click(const QModelIndex &index) {
+	if ((!index.isValid()) || (static_cast<size_t>(index.row()) >= IO_IN_MODULES_COUNT))
+		return;
+	const unsigned addr = static_cast<unsigned>(index.row());
+	this->edited_module = xn_thread.call([addr]() { return rx.modules_in[addr]; });
+	this->edited_module.addr = addr;
+	f_module_edit.moduleOpen(&this->edited_module);
 }
 
-void RcsXn::twUpdateInputModule(unsigned addr) {
-	QTreeWidgetItem *item = this->form.ui.tw_input_modules->topLevelItem(addr);
-	if ((item == nullptr) || (addr >= this->modules_in.size()))
+void RcsXnGui::f_module_edit_accepted() {
+	if (this->f_module_edit.module == nullptr)
 		return;
-	const RcsInputModule& module = this->modules_in[addr];
+	const unsigned moduleAddr = this->edited_module.addr;
 
-	item->setText(0, QString::number(addr));
-	item->setText(1, module.wantActive ? "✓" : "");
-	item->setText(2, module.name);
+	xn_thread.call([this, moduleAddr]() { rx.inputModuleEdited(moduleAddr, this->edited_module); });
+	this->modules_model.moduleChanged(moduleAddr);
+}
 
+void RcsXnGui::onLog(RcsXnLogLevel loglevel, const QString &msg) {
 	{
-		QString delays = "";
-		for (unsigned i = 0; i < module.inputFallDelays.size(); i++) {
-			if (i == (module.inputFallDelays.size()/2))
-				delays += "   ";
-			delays += RcsInputModule::fallDelayToStr(module.inputFallDelays[i]) + "s";
-			if (i < (module.inputFallDelays.size()-1))
-				delays += " ";
-		}
-		item->setText(3, delays);
+		std::lock_guard<std::mutex> lock(this->m_log_lock);
+		if (this->m_log_pending.size() >= MAX_LOGTABLE_ITEMS)
+			this->m_log_pending.pop_front(); // would be overwritten in log table anyway
+		this->m_log_pending.push_back({QTime::currentTime(), loglevel, msg});
 	}
+	this->postFlush();
+}
 
-	this->twUpdateInputModuleInputs(addr);
+void RcsXnGui::postFlush() {
+	if ((this->m_view_active) && (!this->m_flush_posted.exchange(true)))
+		this->inGui([this]() { this->flushPending(); });
 }
 
-void RcsXn::twUpdateInputModuleInputs(unsigned addr) {
-	QTreeWidgetItem *item = this->form.ui.tw_input_modules->topLevelItem(addr);
-	if ((item == nullptr) || (addr >= this->modules_in.size()))
-		return;
-	const RcsInputModule& module = this->modules_in[addr];
-
-	QString state = "";
-	for (unsigned i = 0; i < module.state.size(); i++) {
-		if (i == (module.state.size()/2))
-			state += " ";
-
-		if (!module.realActive)
-			state += "-";
-		else if (module.state[i] == XnInState::on)
-			state += "1";
-		else if (module.state[i] == XnInState::off)
-			state += "0";
-		else if (module.state[i] == XnInState::falling)
-			state += "v";
-		else
-			state += "?";
+void RcsXnGui::flushPending() {
+	this->m_flush_posted = false; // changes from now on need another flush
+
+	std::deque<LogRecord> records;
+	{
+		std::lock_guard<std::mutex> lock(this->m_log_lock);
+		records.swap(this->m_log_pending);
+	}
+	for (const LogRecord &record : records)
+		this->log_model.add(record.loglevel, record.msg, record.time);
+
+	for (size_t word = 0; word < this->m_modules_pending.size(); word++) {
+		uint64_t bits = this->m_modules_pending[word].exchange(0);
+		for (unsigned bit = 0; bits != 0; bit++, bits >>= 1)
+			if (bits & 1)
+				this->modules_model.moduleChanged(static_cast<unsigned>(64*word + bit));
 	}
-	item->setText(4, state);
 }
 
-void RcsXn::tw_input_modules_dbl_click(QTreeWidgetItem *item, int column) {
-	(void)column;
-	f_module_edit.moduleOpen(&this->modules_in[this->form.ui.tw_input_modules->indexOfTopLevelItem(item)]);
+void RcsXnGui::viewVisibilityChanged(bool visible) {
+	this->m_view_active = visible;
+	if (visible)
+		this->flushPending(); // everything collected while hidden
 }
 
-void RcsXn::f_module_edit_accepted() {
-	if (this->f_module_edit.module == nullptr)
+void RcsXnGui::onConfigLoaded() {
+	this->inGui([this]() { this->guiOnConfigLoaded(); });
+}
+
+void RcsXnGui::guiOnConfigLoaded() {
+	Settings s;
+	RcsXnLogLevel loglevel = RcsXnLogLevel::llInfo;
+	SigStorage sigs;
+	xn_thread.call([&]() {
+		s = rx.s;
+		loglevel = rx.loglevel;
+		sigs = rx.sig;
+	});
+
+	this->gui_config_changing = true;
+	form.ui.cb_loglevel->setCurrentIndex(static_cast<int>(loglevel));
+	form.ui.chb_reset_signals->setChecked(s["global"]["resetSignals"].toBool());
+	form.ui.chb_disable_set_output_off->setChecked(s["global"]["disableSetOutputOff"].toBool());
+	form.ui.cb_addr_range->setCurrentIndex((s["global"]["addrRange"].toString() == "lenz") ? 1 : 0);
+	this->fillConnectionsCbs(s);
+	this->gui_config_changing = false;
+
+	this->fillSignals(sigs);
+	this->modules_model.reload();
+	for (int i = 0; i < InputModulesModel::ColCount; ++i)
+		form.ui.tw_input_modules->resizeColumnToContents(i);
+	this->fillActiveOutputs();
+	form.ui.te_binary_outputs->setText(this->binaryOutputsStr());
+	this->guiOnActiveIOCountsChanged();
+}
+
+void RcsXnGui::onModuleChanged(unsigned addr) {
+	this->onModuleInputsChanged(addr);
+}
+
+void RcsXnGui::onModuleInputsChanged(unsigned addr) {
+	if (addr >= IO_IN_MODULES_COUNT)
 		return;
-	const unsigned moduleAddr = this->f_module_edit.module->addr;
+	this->m_modules_pending[addr/64].fetch_or(uint64_t{1} << (addr%64));
+	this->postFlush();
+}
+
+void RcsXnGui::onActiveIOCountsChanged() {
+	this->inGui([this]() { this->guiOnActiveIOCountsChanged(); });
+}
+
+void RcsXnGui::guiOnActiveIOCountsChanged() {
+	unsigned int in_count = 0, out_count = 0;
+	xn_thread.call([&in_count, &out_count]() {
+		in_count = rx.in_count;
+		out_count = rx.out_count;
+	});
+	form.ui.l_in_count->setText(QString::number(in_count));
+	form.ui.l_out_count->setText(QString::number(out_count));
+}
+
+void RcsXnGui::onTrkStatusChanged(Xn::TrkStatus s) {
+	this->inGui([this, s]() { this->guiOnTrkStatusChanged(s); });
+}
 
-	this->twUpdateInputModule(moduleAddr);
-	this->refreshActiveIOCounts();
-	rx.events.call(rx.events.onModuleChanged, moduleAddr);
-	this->saveConfig();
+void RcsXnGui::guiOnTrkStatusChanged(Xn::TrkStatus s) {
+	form.ui.b_dcc_on->setEnabled((s == Xn::TrkStatus::Off));
+	form.ui.b_dcc_off->setEnabled((s == Xn::TrkStatus::On));
+
+	if (s == Xn::TrkStatus::On) {
+		form.ui.l_dcc_state->setText("ON");
+		widgetSetColor(*form.ui.l_dcc_state, Qt::green);
+	} else if (s == Xn::TrkStatus::Off) {
+		form.ui.l_dcc_state->setText("OFF");
+		widgetSetColor(*form.ui.l_dcc_state, Qt::red);
+	} else if (s == Xn::TrkStatus::Programming) {
+		form.ui.l_dcc_state->setText("PROGRAM");
+		widgetSetColor(*form.ui.l_dcc_state, Qt::yellow);
+	} else {
+		form.ui.l_dcc_state->setText("???");
+		widgetSetColor(*form.ui.l_dcc_state, Qt::black);
+	}
 }
 
 } // namespace RcsXn
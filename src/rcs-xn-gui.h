@@ -0,0 +1,141 @@
+#ifndef RCS_XN_GUI_H
+#define RCS_XN_GUI_H
+
+/* Configuration dialog of the library. It observes global RcsXn instance (rx)
+ * and changes its configuration via public methods of RcsXn. This file is
+ * not a part of headless build (RCS_XN_HEADLESS).
+ *
+ * GUI runs in the thread which loaded the library, rx lives in XN thread:
+ * observer methods (called in XN thread) only post the work to GUI thread and
+ * GUI accesses rx only via xn_thread.call. Log records and changed modules are
+ * collected in XN thread and flushed to GUI thread by a single posted call at
+ * a time; nothing is posted while the dialog is hidden.
+ */
+
+#include <QMainWindow>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "form-in-module-edit.h"
+#include "form-signal-edit.h"
+#include "input-modules-model.h"
+#include "log-model.h"
+#include "rcs-xn.h"
+#include "ui_main-window.h"
+#include "xn-thread.h"
+
+namespace RcsXn {
+
+class MainWindow : public QMainWindow {
+	Q_OBJECT
+public:
+	Ui::MainWindow ui;
+	MainWindow(QWidget *parent = nullptr) : QMainWindow(parent) { ui.setupUi(this); }
+
+signals:
+	void visibilityChanged(bool visible);
+
+protected:
+	void showEvent(QShowEvent *event) override {
+		QMainWindow::showEvent(event);
+		emit visibilityChanged(true);
+	}
+	void hideEvent(QHideEvent *event) override {
+		QMainWindow::hideEvent(event);
+		emit visibilityChanged(false);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class RcsXnGui : public QObject, public RcsXnObserver {
+	Q_OBJECT
+
+public:
+	LogModel log_model;
+	InputModulesModel modules_model;
+	MainWindow form;
+	SignalEdit::TmplStorage sig_templates; // copy of rx.sigTemplates edited in f_signal_edit
+	SignalEdit::FormSignalEdit f_signal_edit;
+	FormInModuleEdit f_module_edit;
+
+	explicit RcsXnGui(QObject *parent = nullptr);
+	~RcsXnGui() override;
+
+	void onLog(RcsXnLogLevel, const QString &) override;
+	void onOpen() override;
+	void onClose() override;
+	void onConfigLoaded() override;
+	void onModuleChanged(unsigned addr) override;
+	void onModuleInputsChanged(unsigned addr) override;
+	void onActiveIOCountsChanged() override;
+	void onTrkStatusChanged(Xn::TrkStatus) override;
+
+private slots:
+	void cb_loglevel_changed(int);
+	void cb_interface_type_changed(int);
+	void cb_connections_changed(int);
+	void b_serial_refresh_handle();
+	void b_active_outputs_load_handle();
+	void b_active_outputs_save_handle();
+	void tw_log_double_clicked(const QModelIndex &index);
+	void b_signal_add_handle();
+	void b_signal_remove_handle();
+	void tw_signals_dbl_click(QTreeWidgetItem *, int);
+	void tw_signals_selection_changed();
+	void chb_general_config_changed(int state);
+	void chb_scan_inputs_changed(int state);
+	void b_dcc_on_handle();
+	void b_dcc_off_handle();
+	void tw_input_modules_dbl_click(const QModelIndex &index);
+	void f_module_edit_accepted();
+
+private:
+	bool gui_config_changing = false;
+	unsigned int current_editing_signal = 0;
+	RcsInputModule edited_module; // copy of rx.modules_in[] edited in f_module_edit
+
+	// Written in XN thread, flushed in GUI thread
+	std::atomic<bool> m_view_active {false};
+	std::atomic<bool> m_flush_posted {false};
+	std::mutex m_log_lock;
+	std::deque<LogRecord> m_log_pending; // at most MAX_LOGTABLE_ITEMS
+	std::array<std::atomic<uint64_t>, (IO_IN_MODULES_COUNT+63)/64> m_modules_pending {};
+
+	template <typename F>
+	void inGui(F &&f) {
+		QMetaObject::invokeMethod(this, std::forward<F>(f), Qt::QueuedConnection);
+	}
+
+	void guiInit();
+	void postFlush();
+	void flushPending();
+	void viewVisibilityChanged(bool visible);
+	void guiOnOpen();
+	void guiOnClose();
+	void guiOnConfigLoaded();
+	void guiOnActiveIOCountsChanged();
+	void guiOnTrkStatusChanged(Xn::TrkStatus);
+	void fillConnectionsCbs(Settings &s);
+	void fillPortCb(const QString &configuredPort);
+	QString configuredPort() const;
+	void fillActiveOutputs();
+	QString binaryOutputsStr() const;
+	void fillSignals(const SigStorage &);
+	void guiAddSignal(const XnSignal &);
+	void newSignal(XnSignal);
+	void editedSignal(XnSignal);
+	void setDcc(Xn::TrkStatus);
+	void xn_onDccError(void *, void *);
+	void widgetSetColor(QWidget &widget, const QColor &color);
+};
+
+extern RcsXnGui gui;
+
+} // namespace RcsXn
+
+#endif // RCS_XN_GUI_H
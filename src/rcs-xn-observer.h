@@ -0,0 +1,32 @@
+#ifndef RCS_XN_OBSERVER_H
+#define RCS_XN_OBSERVER_H
+
+/* Interface of optional observer of the library state (configuration dialog).
+ * Core calls observer only when some is attached, so headless build (without
+ * any observer) does no presentation work on state changes at all.
+ */
+
+#include <QString>
+
+#include "common.h"
+#include "lib/xn-lib-cpp-qt/xn.h"
+
+namespace RcsXn {
+
+class RcsXnObserver {
+public:
+	virtual ~RcsXnObserver() = default;
+
+	virtual void onLog(RcsXnLogLevel, const QString &) {} // only records up to RcsXn::loglevel
+	virtual void onOpen() {}
+	virtual void onClose() {}
+	virtual void onConfigLoaded() {} // settings, signals & modules could have changed
+	virtual void onModuleChanged(unsigned) {} // configuration of input module
+	virtual void onModuleInputsChanged(unsigned) {} // input states or realActive of module
+	virtual void onActiveIOCountsChanged() {}
+	virtual void onTrkStatusChanged(Xn::TrkStatus) {}
+};
+
+} // namespace RcsXn
+
+#endif // RCS_XN_OBSERVER_H
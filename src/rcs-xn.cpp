@@ -1,19 +1,37 @@
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
 #include <QSettings>
 #include <QTimer>
 #include <algorithm>
 #include <cstring>
+#include <new>
+#include <type_traits>
 
 #include "errors.h"
 #include "rcs-xn.h"
+#include "xn-thread.h"
+#ifndef RCS_XN_HEADLESS
+#include "rcs-xn-gui.h"
+#endif
 
 namespace RcsXn {
 
 AppThread main_thread;
-RcsXn rx;
+// XnThread is never destroyed (see xn-thread.h); it is constructed in static storage, because
+// RcsXn in it is over-aligned (BitArray) and plain new guarantees less alignment in C++14.
+static typename std::aligned_storage<sizeof(XnThread), alignof(XnThread)>::type xn_thread_storage;
+XnThread &xn_thread = *new (&xn_thread_storage) XnThread();
+RcsXn &rx = xn_thread.core();
+#ifndef RCS_XN_HEADLESS
+RcsXnGui gui; // attaches itself to rx as observer
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 
-RcsXn::RcsXn(QObject *parent) : QObject(parent), f_signal_edit(sigTemplates) {
+RcsXn::RcsXn(QObject *parent)
+	: QObject(parent),
+	  m_fallTimers([this](unsigned module, unsigned port) { inputFellTimeout(module, port); }) {
 	// XN events
 	QObject::connect(&xn, SIGNAL(onError(QString)), this, SLOT(xnOnError(QString)));
     QObject::connect(&xn, SIGNAL(onLog(QString,Xn::LogLevel)), this,
@@ -27,92 +45,123 @@ RcsXn::RcsXn(QObject *parent) : QObject(parent), f_signal_edit(sigTemplates) {
         this, SLOT(xnOnAccInputChanged(uint8_t,bool,bool,Xn::FeedbackType,Xn::AccInputsState))
 	);
 	QObject::connect(&m_acc_reset_timer, SIGNAL(timeout()), this, SLOT(m_acc_reset_timer_tick()));
-	m_acc_reset_timer.setInterval(ACC_RESET_TIMER_PERIOD);
-	m_acc_reset_timer.start();
+	m_acc_reset_timer.setSingleShot(true);
+	m_acc_reset_timer.setTimerType(Qt::PreciseTimer);
+	QObject::connect(&m_outputs_starve_timer, SIGNAL(timeout()), this,
+	                 SLOT(m_outputs_starve_timer_tick()));
+	m_outputs_starve_timer.setSingleShot(true);
+	m_outputs_starve_timer.setTimerType(Qt::PreciseTimer);
+	m_clock.start();
 
-	QObject::connect(&m_resetSignalsTimer, SIGNAL(timeout()), this, SLOT(resetNextSignal()));
-	m_resetSignalsTimer.setInterval(SIGNAL_INIT_RESET_PERIOD);
+	QObject::connect(&m_save_timer, SIGNAL(timeout()), this, SLOT(m_save_timer_tick()));
+	m_save_timer.setSingleShot(true);
+	m_save_timer.setInterval(CONFIG_SAVE_DELAY);
 
-	xn.loglevel = Xn::LogLevel::Debug; // always log everything, let parent application decide what to do with the logs
+	QObject::connect(&m_snapshot_timer, SIGNAL(timeout()), this, SLOT(m_snapshot_timer_tick()));
+	m_snapshot_timer.setInterval(SNAPSHOT_PERIOD);
 
-	// No loading of configuration here (caller should call LoadConfig)
-
-	for (unsigned addr = 0; addr < IO_IN_MODULES_COUNT; addr++)
-		for (unsigned port = 0; port < IO_IN_MODULE_PIN_COUNT; port++)
-			QObject::connect(&this->modules_in[addr].inputFallTimers[port], &QTimer::timeout,
-			                 [this, addr, port](){ inputFellTimeout(addr, port); });
+	this->refreshLogLevel(); // XN library formats only messages someone listens to
 
-	this->guiInit();
-	this->fillConnectionsCbs();
+	// No loading of configuration here (caller should call LoadConfig)
 
 	log("Library loaded.", RcsXnLogLevel::llInfo);
-	this->form.ui.tw_xn_log->resizeColumnToContents(0);
 }
 
 RcsXn::~RcsXn() {
 	try {
 		if (xn.connected())
 			close();
-		if (this->config_filename != "")
-			this->saveConfig(this->config_filename);
+		this->saveConfig();
 	} catch (...) {
 		// No exceptions in destructor!
 	}
+	this->m_log_sink.stop(); // delivers remaining logs, destroyed in XN thread only
 }
 
 void RcsXn::log(const QString &msg, RcsXnLogLevel loglevel) {
-	constexpr size_t COLUMN_COUNT = 3;
+	// parent application has its own threshold (all loglevels by default)
+	if ((loglevel <= this->loglevel_host) && (this->hostLogDefined())) {
+		if (this->m_log_sink.running())
+			this->m_log_sink.push(static_cast<int>(loglevel), msg);
+		else
+			this->hostLog(static_cast<int>(loglevel), msg);
+	}
 
-	// call event for all loglevels, let parent application decide whether to log or not
-	this->events.call(this->events.onLog, static_cast<int>(loglevel), msg);
+	if ((loglevel <= this->loglevel) && (this->observer != nullptr))
+		this->observer->onLog(loglevel, msg);
+}
 
-	if (loglevel > this->loglevel)
-		return;
+bool RcsXn::logEnabled(RcsXnLogLevel loglevel) const {
+	return (((loglevel <= this->loglevel) && (this->observer != nullptr)) ||
+	        ((loglevel <= this->loglevel_host) && (this->hostLogDefined())));
+}
+
+bool RcsXn::hostLogDefined() const {
+	return this->events.onLog.defined() || this->events.onLogBatch.defined();
+}
 
-	// UI
-	if (form.ui.tw_xn_log->topLevelItemCount() > MAX_LOGTABLE_ITEMS)
-		form.ui.tw_xn_log->clear();
-
-	auto *item = new QTreeWidgetItem(form.ui.tw_xn_log);
-	item->setText(0, QTime::currentTime().toString("hh:mm:ss,zzz"));
-
-	if (msg.startsWith("GET:"))
-		for (size_t i = 0; i < COLUMN_COUNT; i++)
-			item->setBackground(i, LOGC_GET);
-	if (msg.startsWith("PUT:"))
-		for (size_t i = 0; i < COLUMN_COUNT; i++)
-			item->setBackground(i, LOGC_PUT);
-
-	if (loglevel == RcsXnLogLevel::llNo)
-		item->setText(1, "Nic");
-	else if (loglevel == RcsXnLogLevel::llError) {
-		item->setText(1, "Chyba");
-		for (size_t i = 0; i < COLUMN_COUNT; i++)
-			item->setBackground(i, LOGC_ERROR);
-	} else if (loglevel == RcsXnLogLevel::llWarning) {
-		item->setText(1, "Varování");
-		for (size_t i = 0; i < COLUMN_COUNT; i++)
-			item->setBackground(i, LOGC_WARN);
-	} else if (loglevel == RcsXnLogLevel::llInfo)
-		item->setText(1, "Info");
-	else if (loglevel == RcsXnLogLevel::llCommands)
-		item->setText(1, "Příkaz");
-	else if (loglevel == RcsXnLogLevel::llRawCommands)
-		item->setText(1, "Data");
-	else if (loglevel == RcsXnLogLevel::llDebug)
-		item->setText(1, "Debug");
-
-	QLabel *label = new QLabel();
-	label->setWordWrap(true);
-	label->setText(msg);
-
-	form.ui.tw_xn_log->addTopLevelItem(item);
-	form.ui.tw_xn_log->setItemWidget(item, 2, label);
+void RcsXn::hostLog(int loglevel, const QString &msg) const {
+	if (this->events.onLog.defined()) {
+		this->events.call(this->events.onLog, loglevel, msg);
+	} else {
+		const EventData<StdLogBatchEvent> e = this->events.onLogBatch;
+		this->events.deliver([this, e, loglevel, msg]() {
+			const RcsLogRecord record {loglevel, reinterpret_cast<const uint16_t *>(msg.utf16())};
+			e.func(&this->events, e.data, &record, 1);
+		});
+	}
+}
+
+AsyncLogSink::Deliver RcsXn::hostLogDeliver() const {
+	// Sink thread gets copies of callbacks, Bind* in XN thread does not race with it
+	const RcsEvents *sender = &this->events;
+	const EventData<StdLogEvent> onLog = this->events.onLog;
+	const EventData<StdLogBatchEvent> onLogBatch = this->events.onLogBatch;
+
+	return [sender, onLog, onLogBatch](const std::vector<QueuedLog> &logs) {
+		if (!onLogBatch.defined()) {
+			if (onLog.defined())
+				for (const QueuedLog &log : logs)
+					onLog.func(sender, onLog.data, log.loglevel, log.msg.utf16());
+			return;
+		}
+
+		std::vector<RcsLogRecord> records;
+		records.reserve(logs.size());
+		for (const QueuedLog &log : logs)
+			records.push_back({log.loglevel, reinterpret_cast<const uint16_t *>(log.msg.utf16())});
+		onLogBatch.func(sender, onLogBatch.data, records.data(),
+		                static_cast<unsigned int>(records.size()));
+	};
+}
+
+void RcsXn::setLogAsync(bool enabled, size_t capacity, LogDropPolicy policy) {
+	if (enabled)
+		this->m_log_sink.start(capacity, policy, this->hostLogDeliver());
+	else
+		this->m_log_sink.stop();
 }
 
 void RcsXn::setLogLevel(RcsXnLogLevel loglevel) {
 	this->loglevel = loglevel;
 	s["XN"]["loglevel"] = static_cast<int>(loglevel);
+	this->refreshLogLevel();
+}
+
+void RcsXn::setHostLogLevel(RcsXnLogLevel loglevel) {
+	this->loglevel_host = loglevel;
+	this->refreshLogLevel();
+}
+
+void RcsXn::refreshLogLevel() {
+	// log callbacks may have changed
+	if (this->m_log_sink.running())
+		this->m_log_sink.setDeliver(this->hostLogDeliver());
+
+	RcsXnLogLevel max = (this->observer != nullptr) ? this->loglevel : RcsXnLogLevel::llNo;
+	if ((this->hostLogDefined()) && (this->loglevel_host > max))
+		max = this->loglevel_host;
+	xn.loglevel = static_cast<Xn::LogLevel>(max);
 }
 
 void RcsXn::error(const QString &message, uint16_t code, unsigned int module) {
@@ -128,7 +177,8 @@ int RcsXn::openDevice(const QString &device, bool persist) {
 
 	this->resetIOState();
 	events.call(rx.events.beforeOpen);
-	this->guiOnOpen();
+	if (this->observer != nullptr)
+		this->observer->onOpen();
 
 	try {
 		xn.connect(device, s["XN"]["baudrate"].toInt(),
@@ -140,14 +190,15 @@ int RcsXn::openDevice(const QString &device, bool persist) {
 		error(errMsg, RCS_CANNOT_OPEN_PORT);
 		log(errMsg, RcsXnLogLevel::llError);
 		events.call(rx.events.afterClose);
-		this->guiOnClose();
+		if (this->observer != nullptr)
+			this->observer->onClose();
 		return RCS_CANNOT_OPEN_PORT;
 	}
 
 	if (persist)
 		s["XN"]["port"] = device;
 
-	if (rx.s["global"]["mockInputs"].toBool())
+	if (this->m_config.mockInputs)
 		this->log("Pozor: simulační režim (mockInputs) aktivován!", RcsXnLogLevel::llWarning);
 
 	return 0;
@@ -184,9 +235,13 @@ int RcsXn::start() {
 	events.call(rx.events.beforeStart);
 	started = RcsStartState::scanning;
 	this->resetIOState();
+	if (this->m_config.warmRestart)
+		this->loadSnapshot();
 	events.call(rx.events.afterStart);
 	log("Komunikace běží.", RcsXnLogLevel::llInfo);	
 	this->first_scan();
+	if (this->m_config.warmRestart)
+		this->m_snapshot_timer.start();
 	return 0;
 }
 
@@ -196,11 +251,13 @@ int RcsXn::stop() {
 
 	log("Zastavuji komunikaci...", RcsXnLogLevel::llInfo);
 	events.call(rx.events.beforeStop);
+	this->m_snapshot_timer.stop();
+	if ((this->m_config.warmRestart) && (this->started == RcsStartState::started))
+		this->saveSnapshot(); // close() requires stop() -> snapshot is always written before close
 	this->started = RcsStartState::stopped;
-	for (RcsInputModule& module : this->modules_in) {
+	for (RcsInputModule& module : this->modules_in)
 		module.realActive = false;
-		module.stopAllFallTimers();
-	}
+	this->m_fallTimers.cancelAll();
 	this->resetIOState();
 	events.call(rx.events.afterStop);
 	log("Komunikace zastavena", RcsXnLogLevel::llInfo);
@@ -208,17 +265,34 @@ int RcsXn::stop() {
 }
 
 void RcsXn::loadConfig(const QString &filename) {
-	QSettings qset(filename, QSettings::IniFormat);
+	this->m_save_timer.stop();
+	this->m_save_all = true; // until config is loaded successfully
+	this->m_dirty_signals.clear();
+	this->m_dirty_modules.clear();
+
+	std::vector<IniError> errors;
+	IniData data = IniData::fromFile(filename, errors);
+	if (!errors.empty()) {
+		for (const IniError &error : errors)
+			this->log(filename + ":" + QString::number(error.line) + ": " + error.message,
+			          RcsXnLogLevel::llWarning);
+		this->log("Konfigurace bude načtena přes QSettings.", RcsXnLogLevel::llInfo);
+
+		QSettings qset(filename, QSettings::IniFormat);
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-	s.setIniCodec("UTF-8");
+		qset.setIniCodec("UTF-8");
 #endif
+		data = IniData::fromSettings(qset);
+	}
 
-	s.load(qset, false); // do not load & store nonDefaults
+	s.load(data, false); // do not load & store nonDefaults
+	this->refreshRuntimeConfig();
 
 	bool ok;
 	this->loglevel = static_cast<RcsXnLogLevel>(s["XN"]["loglevel"].toInt(&ok));
 	if (!ok)
 		throw QStrException("logLevel invalid type!");
+	this->refreshLogLevel();
 
 	Xn::XNConfig xnconfig;
 	xnconfig.outInterval = s["XN"]["outIntervalMs"].toUInt(&ok);
@@ -226,24 +300,14 @@ void RcsXn::loadConfig(const QString &filename) {
 		throw QStrException("outIntervalMs invalid type!");
 	this->xn.setConfig(xnconfig);
 
-	this->gui_config_changing = true;
-	try {
-		form.ui.cb_loglevel->setCurrentIndex(static_cast<int>(this->loglevel));
-		form.ui.chb_reset_signals->setChecked(s["global"]["resetSignals"].toBool());
-		form.ui.chb_disable_set_output_off->setChecked(s["global"]["disableSetOutputOff"].toBool());
-		if (s["global"]["addrRange"].toString() == "basic")
-			form.ui.cb_addr_range->setCurrentIndex(0);
-		else if (s["global"]["addrRange"].toString() == "lenz")
-			form.ui.cb_addr_range->setCurrentIndex(1);
-		else {
-			s["global"]["addrRange"] = "basic";
-			form.ui.cb_addr_range->setCurrentIndex(0);
-		}
-		this->fillConnectionsCbs();
+	if ((s["global"]["addrRange"].toString() != "basic") &&
+	    (s["global"]["addrRange"].toString() != "lenz"))
+		s["global"]["addrRange"] = "basic";
 
-		this->loadSignals(qset);
+	try {
+		this->loadSignals(data);
 
-		this->loadInputModules(qset);
+		this->loadInputModules(data);
 
 		try {
 			this->loadActiveIO(s["modules"]["active-in"].toString(),
@@ -253,7 +317,6 @@ void RcsXn::loadConfig(const QString &filename) {
 			          RcsXnLogLevel::llError);
 			throw;
 		}
-		this->fillActiveOutputs();
 
 		try {
 			this->parseModules(s["modules"]["binary"].toString(), this->binary, false);
@@ -262,159 +325,371 @@ void RcsXn::loadConfig(const QString &filename) {
 			          RcsXnLogLevel::llError);
 			throw;
 		}
-		form.ui.te_binary_outputs->setText(getActiveStr(this->binary, ",\n"));
 
-		this->gui_config_changing = false;
+		this->m_saved_templates = this->sigTemplates;
+		this->m_save_all = false; // file content corresponds to loaded config now
 	} catch (...) {
-		this->fillSignals();
-		this->fillActiveOutputs();
-		form.ui.te_binary_outputs->setText(getActiveStr(this->binary, ",\n"));
-
-		this->gui_config_changing = false;
+		this->publishIO();
+		if (this->observer != nullptr)
+			this->observer->onConfigLoaded();
 		throw;
 	}
-}
 
-void RcsXn::first_scan() {
-	log("Skenuji stav aktivních vstupů...", RcsXnLogLevel::llInfo);
-	for (unsigned i = 0; i < IO_IN_MODULES_COUNT; i++) {
-		this->modules_in[i].realActive = false;
-		this->twUpdateInputModuleInputs(i);
-	}
-	this->scanNextGroup(-1);
+	this->publishIO();
+
+	if (this->observer != nullptr)
+		this->observer->onConfigLoaded();
 }
 
 void RcsXn::saveConfig() {
-	this->saveConfig(this->config_filename);
+	// Writes only changed signals, templates & modules to current config file
+	this->m_save_timer.stop();
+	if (this->config_filename == "")
+		return;
+	this->writeConfig(this->config_filename, this->m_save_all);
 }
 
 void RcsXn::saveConfig(const QString &filename) {
-	s["modules"]["active-out"] = getActiveStr(this->user_active_out, ",");
-	s["modules"]["binary"] = getActiveStr(this->binary, ",");
+	this->writeConfig(filename, true);
+}
+
+void RcsXn::configChanged() {
+	// Debounced: multiple edits shortly after each other are saved together
+	this->m_save_timer.start();
+}
+
+void RcsXn::m_save_timer_tick() {
+	try {
+		this->saveConfig();
+	} catch (const QStrException &e) {
+		this->log("Nepodařilo se uložit konfiguraci: " + e.str(), RcsXnLogLevel::llError);
+	} catch (...) {
+		this->log("Nepodařilo se uložit konfiguraci!", RcsXnLogLevel::llError);
+	}
+}
+
+void RcsXn::writeConfig(const QString &filename, bool all) {
+	/* Config is written to temporary file first (copy of current file when
+	 * writing only changes), target file is replaced by it atomically, so
+	 * crash during save never leaves half-written config.
+	 */
+	s["modules"]["active-out"] = RangeCodec::serialize(this->user_active_out, ",");
+	s["modules"]["binary"] = RangeCodec::serialize(this->binary, ",");
 	s["modules"].erase("active-in");
 
-	QSettings qset(filename, QSettings::IniFormat);
+	const QString tmpFilename = filename + ".tmp";
+	QFile::remove(tmpFilename);
+	if ((!all) && (QFile::exists(filename)) && (!QFile::copy(filename, tmpFilename)))
+		throw QStrException("Nelze vytvořit soubor " + tmpFilename);
+	all = all || (!QFile::exists(tmpFilename));
+
+	{
+		QSettings qset(tmpFilename, QSettings::IniFormat);
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-	s.setIniCodec("UTF-8");
+		qset.setIniCodec("UTF-8");
 #endif
 
-	s.save(qset);
-	this->saveSignals(qset);
-	this->saveInputModules(qset);
+		s.save(qset);
+		if (all) {
+			this->saveSignals(qset);
+			this->saveInputModules(qset);
+		} else {
+			this->saveSignalsChanges(qset);
+			this->saveInputModulesChanges(qset);
+		}
+
+		qset.sync();
+		if (qset.status() != QSettings::NoError)
+			throw QStrException("Nelze zapsat soubor " + tmpFilename);
+	}
+
+	QFile tmp(tmpFilename);
+	if (!tmp.open(QIODevice::ReadOnly))
+		throw QStrException("Nelze otevřít soubor " + tmpFilename);
+	QSaveFile target(filename);
+	if ((!target.open(QIODevice::WriteOnly)) || (target.write(tmp.readAll()) < 0) ||
+	    (!target.commit()))
+		throw QStrException("Nelze zapsat soubor " + filename);
+	tmp.close();
+	tmp.remove();
+
+	if (filename == this->config_filename) {
+		this->m_dirty_signals.clear();
+		this->m_dirty_modules.clear();
+		this->m_saved_templates = this->sigTemplates;
+		this->m_save_all = false;
+	}
+}
+
+QString RcsXn::snapshotFilename() const {
+	if (this->config_filename == "")
+		return "";
+	return this->config_filename + ".snapshot";
+}
+
+void RcsXn::saveSnapshot() {
+	const QString filename = this->snapshotFilename();
+	if (filename == "")
+		return;
+
+	IoSnapshot snapshot;
+	snapshot.timestamp = QDateTime::currentMSecsSinceEpoch();
+	for (unsigned addr = 0; addr < IO_IN_MODULES_COUNT; addr++) {
+		snapshot.inputs[addr] = this->modules_in[addr].state.raw();
+		snapshot.realActive.set(addr, this->modules_in[addr].realActive);
+	}
+	snapshot.outputs = this->outputs;
+	// pulse output waiting for its reset is off after restart
+	for (unsigned port = 0; port < IO_COUNT; port++)
+		if (this->m_accToResetArr[port] != 0)
+			snapshot.outputs.set(port, false);
+	for (const auto &signal : this->sig)
+		snapshot.signalCodes[signal.first] = signal.second.currentCode;
+
+	try {
+		snapshot.save(filename);
+	} catch (const QStrException &e) {
+		this->log("Nepodařilo se uložit snapshot stavu: " + e.str(), RcsXnLogLevel::llWarning);
+	}
+}
+
+void RcsXn::m_snapshot_timer_tick() {
+	if (this->started == RcsStartState::started)
+		this->saveSnapshot();
+}
+
+void RcsXn::loadSnapshot() {
+	// Expects state after resetIOState
+	const QString filename = this->snapshotFilename();
+	if ((filename == "") || (!QFile::exists(filename)))
+		return;
+
+	IoSnapshot snapshot;
+	QString err;
+	if (!IoSnapshot::load(filename, snapshot, err)) {
+		this->log("Snapshot stavu nenačten: " + err, RcsXnLogLevel::llWarning);
+		return;
+	}
+
+	const qint64 age = QDateTime::currentMSecsSinceEpoch() - snapshot.timestamp;
+	if ((this->m_config.warmRestartMaxAge > 0) &&
+	    ((age < 0) || (age > qint64{this->m_config.warmRestartMaxAge} * 1000))) {
+		this->log("Snapshot stavu nenačten: stáří " + QString::number(age / 1000) +
+		          " s, maximum je " + QString::number(this->m_config.warmRestartMaxAge) + " s.",
+		          RcsXnLogLevel::llWarning);
+		return;
+	}
+
+	for (unsigned addr = 0; addr < IO_IN_MODULES_COUNT; addr++) {
+		if ((!this->modules_in[addr].wantActive) || (!snapshot.realActive[addr]))
+			continue;
+		this->modules_in[addr].state.setRaw(snapshot.inputs[addr]);
+		// falling timers are not restored -> falling is treated as off
+		for (unsigned port = 0; port < IO_IN_MODULE_PIN_COUNT; port++)
+			if (this->modules_in[addr].state[port] == XnInState::falling)
+				this->modules_in[addr].state.set(port, XnInState::off);
+		this->m_input_provisional.set(addr, true);
+		this->updateInputsBitmap(addr);
+	}
+
+	this->outputs = snapshot.outputs;
+	for (const auto &code : snapshot.signalCodes) {
+		auto it = this->sig.find(code.first);
+		if (it != this->sig.end())
+			it->second.currentCode = code.second;
+	}
+	this->publishIO();
+
+	this->log("Načten snapshot stavu z " +
+	          QDateTime::fromMSecsSinceEpoch(snapshot.timestamp).toString("yyyy-MM-dd hh:mm:ss") +
+	          " (" + QString::number(this->m_input_provisional.count()) +
+	          " vstupních modulů).", RcsXnLogLevel::llInfo);
+}
+
+void RcsXn::provisionalInputDone(unsigned int module) {
+	if (!this->m_input_provisional[module])
+		return;
+	this->m_input_provisional.set(module, false);
+	this->publishInput(module);
+
+	if (!this->modules_in[module].realActive) {
+		// module did not respond to scan -> provisional state is not valid anymore
+		this->modules_in[module].state.fill(XnInState::unknown);
+		this->updateInputsBitmap(module);
+		events.call(events.onInputChanged, module);
+		if (this->observer != nullptr)
+			this->observer->onModuleInputsChanged(module);
+	}
 }
 
 void RcsXn::loadActiveIO(const QString &inputs, const QString &outputs, bool except) {
 	// inputs: just backward compatibility
-	std::array<bool, IO_IN_MODULES_COUNT> user_active_in;
+	BitArray<IO_IN_MODULES_COUNT> user_active_in;
 	this->parseModules(inputs, user_active_in, except);
 	for (unsigned addr = 0; addr < IO_IN_MODULES_COUNT; addr++) {
 		if (user_active_in[addr]) {
 			this->modules_in[addr].wantActive = true;
-			this->twUpdateInputModule(addr);
+			this->m_dirty_modules.insert(addr);
+			if (this->observer != nullptr)
+				this->observer->onModuleChanged(addr);
 		}
 	}
 
 	this->parseModules(outputs, this->user_active_out, except);
+	// all modules could have changed -> full recount
 
 	this->refreshActiveIOCounts();
 
-	if ((s["global"]["addrRange"].toString() == "lenz") && (this->user_active_out[0]))
+	if ((this->m_config.addrRange == AddrRange::lenz) && (this->user_active_out[0]))
 		throw EInvalidRange("Adresa výstupu 0 není validní adresou systému Lenz!");
 	// if ((s["global"]["addrRange"].toString() == "lenz") && (this->user_active_in[0]))
 	//	throw EInvalidRange("Adresa vstupního modulu 0 není validní adresou systému Lenz!");
 }
 
-void RcsXn::initModuleScanned(uint8_t group, bool nibble) {
-	static int nibbles_scanned = 0;
-	int received_nibble = static_cast<int>(nibble)+1;
+void RcsXn::setActiveIO(const QString &outputs, const QString &binary) {
+	this->loadActiveIO("", outputs);
+	this->parseModules(binary, this->binary, true);
+	this->saveConfig();
+}
+
+/* Initial scan keeps up to m_scan_window groups in flight. Each group is
+ * finished when both nibbles are received (or given up after
+ * SCAN_MAX_RETRIES timeouts). Responses are matched by group address.
+ */
 
-	if (this->started != RcsStartState::scanning)
+unsigned RcsXn::scanWindow() {
+	bool ok;
+	const unsigned window = s["XN"]["scanWindow"].toUInt(&ok);
+	if ((ok) && (window > 0))
+		return window;
+	// LI-USB-Eth has problems with multiple commands -> scan serially
+	return (this->xn.liType() == Xn::LIType::LIUSBEth) ? 1 : static_cast<unsigned>(SCAN_DEFAULT_WINDOW);
+}
+
+void RcsXn::scanFill() {
+	while ((this->m_scan_in_flight < this->m_scan_window) &&
+	       (this->m_scan_next < IO_IN_MODULES_COUNT)) {
+		const unsigned group = this->m_scan_next++;
+		if (this->modules_in[group].wantActive)
+			this->scanRequestGroup(group);
+	}
+
+	if ((this->m_scan_in_flight == 0) && (this->m_scan_next >= IO_IN_MODULES_COUNT))
+		this->initScanningDone();
+}
+
+void RcsXn::scanRequestGroup(unsigned group) {
+	this->m_scan_pending[group] = true;
+	this->m_scan_nibbles[group] = 0;
+	this->m_scan_retries[group] = 0;
+	this->m_scan_in_flight++;
+
+	this->scanRequestNibble(group, false);
+	if (this->xn.liType() != Xn::LIType::LIUSBEth) // LI-USB-Eth: nibbles are requested serially
+		this->scanRequestNibble(group, true);
+}
+
+void RcsXn::scanRequestNibble(unsigned group, bool nibble) {
+	const unsigned generation = this->m_scan_generation;
+	xn.accInfoRequest(
+		inBusModuleAddr(static_cast<uint8_t>(group)), nibble,
+		std::make_unique<Xn::Cb>([this, group, nibble, generation](void *, void *) {
+			xnOnInitScanningError(group, nibble, generation);
+		})
+	);
+}
+
+void RcsXn::scanGroupDone(unsigned group) {
+	this->m_scan_pending[group] = false;
+	this->provisionalInputDone(group);
+	if (this->m_scan_in_flight > 0)
+		this->m_scan_in_flight--;
+}
+
+void RcsXn::initModuleScanned(uint8_t group, bool nibble) {
+	if ((this->started != RcsStartState::scanning) || (!this->m_scan_pending[group]))
 		return;
 
-	if (nibbles_scanned == received_nibble) {
+	const uint8_t received_nibble = static_cast<uint8_t>(nibble)+1;
+
+	if (this->m_scan_nibbles[group] & received_nibble) {
 		// LZV100 does this: it responds 2 times with same nibble when module not connected
-		// -> go to next message directly
-		uint8_t old_scan_group = this->scan_group;
+		// -> finish the group directly
 		log("Module scanning: invalid response!", RcsXnLogLevel::llError);
-		xn.pendingClear();
-		if (this->scan_group == old_scan_group && this->started != RcsStartState::started) {
-			// Buffer clear did not automatically call scanNextGroup -> call it manually
-			nibbles_scanned = 0;
-			this->scanNextGroup(this->scan_group);
-		}
+		this->scanGroupDone(group);
+		if (this->m_scan_in_flight == 0)
+			xn.pendingClear(); // remove request for other nibble, no other group is waiting
+		this->scanFill();
 		return;
 	}
 
-	nibbles_scanned |= received_nibble; // fill 2 LSBs
+	this->m_scan_nibbles[group] |= received_nibble; // fill 2 LSBs
 
-	if (nibbles_scanned == 1 && this->xn.liType() == Xn::LIType::LIUSBEth) {
-		// LI-USB-Eth has problems with multiple commands -> send serially
-		xn.accInfoRequest(
-			inBusModuleAddr(this->scan_group), true,
-			std::make_unique<Xn::Cb>([this](void *s, void *d) { xnOnInitScanningError(s, d); },
-									 reinterpret_cast<void *>(true))
-		);
-	}
+	if (this->m_scan_nibbles[group] == 1 && this->xn.liType() == Xn::LIType::LIUSBEth)
+		this->scanRequestNibble(group, true);
 
-	if (nibbles_scanned != 3) // not both nibbles scanned -> wait for other nibble
+	if (this->m_scan_nibbles[group] != 3) // not both nibbles scanned -> wait for other nibble
 		return;
 
-	nibbles_scanned = 0;
-	this->scanNextGroup(group);
+	this->scanGroupDone(group);
+	this->scanFill();
 }
 
-void RcsXn::scanNextGroup(int previousGroup) {
-	unsigned int nextGroup = previousGroup+1;
-
-	while ((nextGroup < IO_IN_MODULES_COUNT) && (!this->modules_in[nextGroup].wantActive))
-		nextGroup += 1;
-
-	if (nextGroup >= IO_IN_MODULES_COUNT) {
-		this->initScanningDone();
-		return;
+void RcsXn::first_scan() {
+	log("Skenuji stav aktivních vstupů...", RcsXnLogLevel::llInfo);
+	for (unsigned i = 0; i < IO_IN_MODULES_COUNT; i++) {
+		this->modules_in[i].realActive = this->m_input_provisional[i]; // until scanned
+		this->publishInput(i);
+		if (this->observer != nullptr)
+			this->observer->onModuleInputsChanged(i);
 	}
 
-	this->scan_group = nextGroup;
+	this->m_scan_generation++;
+	std::fill(this->m_scan_pending.begin(), this->m_scan_pending.end(), false);
+	this->m_scan_in_flight = 0;
+	this->m_scan_next = 0;
+	this->m_scan_window = this->scanWindow();
+	this->scanFill();
+}
 
-	// Scan both nibbles
-	xn.accInfoRequest(
-		inBusModuleAddr(this->scan_group), false,
-	    std::make_unique<Xn::Cb>([this](void *s, void *d) { xnOnInitScanningError(s, d); },
-	                             reinterpret_cast<void *>(false))
-	);
+void RcsXn::xnOnInitScanningError(unsigned group, bool nibble, unsigned generation) {
+	if ((generation != this->m_scan_generation) || (this->started != RcsStartState::scanning) ||
+	    (!this->m_scan_pending[group]))
+		return;
 
-	if (this->xn.liType() != Xn::LIType::LIUSBEth) {
-		// LI-USB-Eth has problems with multiple commands
-		xn.accInfoRequest(
-			inBusModuleAddr(this->scan_group), true,
-			std::make_unique<Xn::Cb>([this](void *s, void *d) { xnOnInitScanningError(s, d); },
-			                         reinterpret_cast<void *>(true))
-		);
+	if (this->m_scan_retries[group] < SCAN_MAX_RETRIES) {
+		this->m_scan_retries[group]++;
+		logLazy([group]() { return "Module scanning: no response, retrying module " +
+		                           QString::number(group) + "..."; },
+		        RcsXnLogLevel::llWarning);
+		this->scanRequestNibble(group, nibble);
+		return;
 	}
-}
 
-void RcsXn::xnOnInitScanningError(void *, void *data) {
 	log("Module scanning: no response!", RcsXnLogLevel::llError);
-	bool nibble = static_cast<bool>(data);
-	this->modules_in[this->scan_group].realActive = false;
-	this->twUpdateInputModuleInputs(this->scan_group);
-	this->initModuleScanned(this->scan_group, nibble); // continue scanning
+	this->modules_in[group].realActive = false;
+	this->publishInput(group);
+	if (this->observer != nullptr)
+		this->observer->onModuleInputsChanged(group);
+	this->initModuleScanned(static_cast<uint8_t>(group), nibble); // continue scanning
 }
 
 void RcsXn::initScanningDone() {
 	log("Stav vstupů naskenován.", RcsXnLogLevel::llInfo);
 
-	if (rx.s["global"]["mockInputs"].toBool()) {
+	if (this->m_config.mockInputs) {
 		for (RcsInputModule& module : this->modules_in) {
 			module.realActive = module.wantActive;
-			this->twUpdateInputModuleInputs(module.addr);
+			this->publishInput(module.addr);
+			if (this->observer != nullptr)
+				this->observer->onModuleInputsChanged(module.addr);
 		}
 	}
 
 	this->started = RcsStartState::started;
 	events.call(events.onScanned);
 
-	if (this->s["global"]["resetSignals"].toBool())
+	if (this->m_config.resetSignals)
 		this->resetSignals();
 }
 
@@ -427,100 +702,191 @@ void RcsXn::xnSetOutputOk(unsigned int portAddr, int state) {
 		id++;
 		if (id == 0)
 			id = 1;
-		m_accToResetDeq.emplace_back(id, portAddr, QDateTime::currentDateTime().addMSecs(OUTPUT_ACTIVE_TIME));
+		// OUTPUT_ACTIVE_TIME is constant -> appending keeps the deque ordered by resetTime
+		m_accToResetDeq.emplace_back(id, portAddr, m_clock.elapsed() + OUTPUT_ACTIVE_TIME);
 		m_accToResetArr[portAddr] = id; // so we know which reset time is valid
+		this->accResetSchedule();
 	}
+
+	this->outputsSend();
+	this->resetNextSignals();
 }
 
-void RcsXn::xnSetOutputError(unsigned int module) {
+void RcsXn::xnSetOutputError(unsigned int portAddr) {
 	// TODO: mark module as failed?
+	const unsigned int module = portAddr / IO_OUT_MODULE_PIN_COUNT;
 	if (this->m_acc_op_pending_count > 0)
 		this->m_acc_op_pending_count--;
 	error("Command Station did not respond to SetOutput command!", RCS_MODULE_NOT_ANSWERED_CMD,
 	      module);
+
+	// State of decoder output is unknown -> signal sends it again with next aspect
+	for (auto &signal : this->sig) {
+		XnSignal &xnSig = signal.second;
+		if ((module >= xnSig.startAddr) && (module - xnSig.startAddr < xnSig.outputsState.size()))
+			xnSig.outputsState[module - xnSig.startAddr] = 0;
+	}
+	this->outputsSend();
+	this->resetNextSignals();
 }
 
-int RcsXn::setPlainOutput(unsigned int portAddr, int state, bool setInternalState) {
+int RcsXn::setPlainOutput(unsigned int portAddr, int state, bool setInternalState,
+                          OutputPriority priority) {
 	unsigned int module = portAddr / IO_OUT_MODULE_PIN_COUNT;
 	unsigned int port = portAddr % IO_OUT_MODULE_PIN_COUNT;
-	unsigned int realPortAddr = portAddr;
 
 	if (setInternalState) {
 		// Checks only done for non-signal outputs
 
 		unsigned int secondPort = (module<<1) + !(port&1); // 0-2047
 		if (state > 0)
-			outputs[secondPort] = false;
+			outputs.set(secondPort, false);
 
-		outputs[portAddr] = static_cast<bool>(state);
+		outputs.set(portAddr, static_cast<bool>(state));
+		this->publishOutput(module);
 	}
 
-	if (s["global"]["addrRange"].toString() == "lenz") {
+	if (this->m_config.addrRange == AddrRange::lenz) {
 		if (module == 0) {
-			log("Invalid acc port (using Lenz addresses): " + QString::number(portAddr),
-			    RcsXnLogLevel::llWarning);
+			logLazy([portAddr]() { return "Invalid acc port (using Lenz addresses): " +
+			                              QString::number(portAddr); },
+			        RcsXnLogLevel::llWarning);
 			return RCS_PORT_INVALID_NUMBER;
 		}
-		realPortAddr -= IO_OUT_MODULE_PIN_COUNT;
 	}
 
-	if ((s["global"]["disableSetOutputOff"].toBool()) && (rx.xn.getTrkStatus() != Xn::TrkStatus::On))
+	if ((this->m_config.disableSetOutputOff) && (this->xn.getTrkStatus() != Xn::TrkStatus::On))
 		return RCS_MODULE_INVALID_ADDR;
 
-	this->m_acc_op_pending_count++;
-	xn.accOpRequest(
-		static_cast<uint16_t>(realPortAddr), static_cast<bool>(state),
-		std::make_unique<Xn::Cb>([this, portAddr, state](void *, void *) { this->xnSetOutputOk(portAddr, state); }),
-		std::make_unique<Xn::Cb>([this, module](void *, void *) { this->xnSetOutputError(module); })
-	);
+	this->m_outputs_queue.push(priority, static_cast<uint16_t>(portAddr), static_cast<bool>(state),
+	                           m_clock.elapsed(), this->m_config.outputCoalesceMs);
+	this->outputsSend();
 
-	if (state == 0)
-		m_accToResetArr[portAddr] = 0;
+	// Pending reset belongs to older command of the port, it must not cut this one short
+	m_accToResetArr[portAddr] = 0;
 
-	events.call(events.onOutputChanged, module); // TODO: move to ok callback?
+	this->outputChanged(module); // TODO: move to ok callback?
 	return 0;
 }
 
-template <std::size_t ArraySize>
-void RcsXn::parseModules(const QString &active, std::array<bool, ArraySize> &result,
-                         bool except) {
-	std::fill(result.begin(), result.end(), false);
+void RcsXn::outputsSend() {
+	// Only few commands are handed to XN library (FIFO), rest waits in priority queue;
+	// starving command may take one extra slot
+	while ((!this->m_outputs_queue.empty()) &&
+	       ((this->m_acc_op_pending_count < OUTPUT_MAX_IN_FLIGHT) ||
+	        ((this->m_acc_op_pending_count < OUTPUT_MAX_IN_FLIGHT_STARVING) &&
+	         (this->m_outputs_queue.starving(m_clock.elapsed()))))) {
+		const QueuedOutput output = this->m_outputs_queue.pop(m_clock.elapsed());
+		const unsigned int portAddr = output.portAddr;
+		const int state = output.state;
+		const unsigned int realPortAddr = (this->m_config.addrRange == AddrRange::lenz)
+			? portAddr - IO_OUT_MODULE_PIN_COUNT : portAddr;
+
+		this->m_acc_op_pending_count++;
+		xn.accOpRequest(
+			static_cast<uint16_t>(realPortAddr), output.state,
+			std::make_unique<Xn::Cb>([this, portAddr, state](void *, void *) { this->xnSetOutputOk(portAddr, state); }),
+			std::make_unique<Xn::Cb>([this, portAddr](void *, void *) { this->xnSetOutputError(portAddr); })
+		);
+	}
 
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-	const QStringList ranges = active.split(',', QString::SkipEmptyParts);
-#else
-	const QStringList ranges = active.split(',', Qt::SkipEmptyParts);
-#endif
+	// Completions are not the only moment to check starvation, OUTPUT_MAX_WAIT is a real bound
+	const qint64 next = this->m_outputs_queue.nextStarving();
+	const qint64 now = m_clock.elapsed();
+	if ((next == OUTPUT_NO_DEADLINE) || (next <= now))
+		this->m_outputs_starve_timer.stop(); // already starving -> next completion sends it
+	else
+		this->m_outputs_starve_timer.start(static_cast<int>(next - now));
+}
 
-	for (const QString &range : ranges) {
-		const QStringList bounds = range.split('-');
-		bool okl, okr = false;
-		if (bounds.size() == 1) {
-			unsigned int addr = bounds[0].toUInt(&okl);
-			if ((okl) && (addr < result.size())) {
-				result[addr] = true;
-			} else {
-				if (except)
-					throw EInvalidRange("Invalid range: " + bounds[0]);
-				log("Invalid range: " + bounds[0], RcsXnLogLevel::llWarning);
-			}
-		} else if (bounds.size() == 2) {
-			unsigned int left = bounds[0].toUInt(&okl);
-			unsigned int right = bounds[1].toUInt(&okr);
-			if ((okl) & (okr) && (left < result.size()) && (right < result.size())) {
-				for (size_t i = left; i <= right; i++)
-					result[i] = true;
-			} else {
-				if (except)
-					throw EInvalidRange("Invalid range: " + range);
-				log("Invalid range: " + range, RcsXnLogLevel::llWarning);
-			}
-		} else {
-			if (except)
-				throw EInvalidRange("Invalid range: " + range);
-			log("Invalid range: " + range, RcsXnLogLevel::llWarning);
+size_t RcsXn::outputsPending() const {
+	return this->m_acc_op_pending_count + this->m_outputs_queue.size();
+}
+
+int RcsXn::setOutput(unsigned int module, unsigned int port, int state) {
+	unsigned int portAddr = (module<<1) + (port&1); // 0-2047
+
+	if (this->isSignal(portAddr)) {
+		this->sig.at(module).setByHost = true;
+		return this->setSignal(static_cast<uint16_t>(portAddr), static_cast<unsigned int>(state));
+	}
+
+	if ((this->binary[module]) && (state == 0)) {
+		portAddr = (module<<1) + ((!port)&1);
+		state = 1;
+	}
+	if (this->outputs[portAddr] == static_cast<bool>(state))
+		return 0;
+	return this->setPlainOutput(portAddr, state, true);
+}
+
+int RcsXn::setOutputs(const std::vector<OutputCmd> &cmds) {
+	/* Only the last write to each port is performed (in order of first
+	 * occurrence of the port in the batch). Writes resulting in current state
+	 * of the port are dropped in setOutput. onOutputChanged is called once per
+	 * changed module after the whole batch is sent.
+	 */
+	std::array<int, IO_COUNT> lastCmd;
+	std::fill(lastCmd.begin(), lastCmd.end(), -1);
+	std::vector<unsigned int> order;
+	order.reserve(cmds.size());
+
+	for (size_t i = 0; i < cmds.size(); i++) {
+		const unsigned int portAddr = (cmds[i].module<<1) + (cmds[i].port&1);
+		if (lastCmd[portAddr] == -1)
+			order.push_back(portAddr);
+		lastCmd[portAddr] = static_cast<int>(i);
+	}
+
+	std::fill(m_outputs_batch_changed.begin(), m_outputs_batch_changed.end(), false);
+	this->m_outputs_batch = true;
+
+	int retval = 0;
+	try {
+		for (unsigned int portAddr : order) {
+			const OutputCmd &cmd = cmds[static_cast<size_t>(lastCmd[portAddr])];
+			int subret = this->setOutput(cmd.module, cmd.port, cmd.state);
+			if (subret != 0 && retval == 0)
+				retval = subret;
 		}
+	} catch (...) {
+		this->m_outputs_batch = false;
+		throw;
 	}
+
+	this->m_outputs_batch = false;
+	for (unsigned int module = 0; module < IO_OUT_MODULES_COUNT; module++)
+		if (m_outputs_batch_changed[module])
+			events.call(events.onOutputChanged, module);
+
+	return retval;
+}
+
+void RcsXn::outputChanged(unsigned int module) {
+	if (this->m_outputs_batch) {
+		if (module < IO_OUT_MODULES_COUNT)
+			this->m_outputs_batch_changed[module] = true;
+		return;
+	}
+	events.call(events.onOutputChanged, module);
+}
+
+template <std::size_t ArraySize>
+void RcsXn::parseModules(const QString &active, BitArray<ArraySize> &result, bool except) {
+	const std::vector<RangeError> errors = RangeCodec::parse(active, result);
+	if (errors.empty())
+		return;
+
+	QString msg = "Invalid range: ";
+	for (size_t i = 0; i < errors.size(); i++) {
+		if (i > 0)
+			msg += ", ";
+		msg += errors[i].token + " (pos " + QString::number(errors[i].position) + ")";
+	}
+
+	if (except)
+		throw EInvalidRange(msg);
+	log(msg, RcsXnLogLevel::llWarning);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -537,11 +903,13 @@ void RcsXn::xnOnError(QString error) {
 }
 
 void RcsXn::xnOnLog(QString message, Xn::LogLevel loglevel) {
-	this->log(message, static_cast<RcsXnLogLevel>(loglevel));
+	if (this->logEnabled(static_cast<RcsXnLogLevel>(loglevel)))
+		this->log(message, static_cast<RcsXnLogLevel>(loglevel));
 }
 
 void RcsXn::xnOnConnect() {
 	this->opening = true;
+	this->connected = true;
 
 	try {
 		xn.getLIVersion(
@@ -555,27 +923,18 @@ void RcsXn::xnOnConnect() {
 }
 
 void RcsXn::xnOnDisconnect() {
+	this->connected = false;
+	this->opening = false;
+	this->publishOutputsRejected();
 	this->events.call(this->events.afterClose);
-	this->guiOnClose();
+	if (this->observer != nullptr)
+		this->observer->onClose();
 }
 
 void RcsXn::xnOnTrkStatusChanged(Xn::TrkStatus s) {
-	form.ui.b_dcc_on->setEnabled((s == Xn::TrkStatus::Off));
-	form.ui.b_dcc_off->setEnabled((s == Xn::TrkStatus::On));
-
-	if (s == Xn::TrkStatus::On) {
-		form.ui.l_dcc_state->setText("ON");
-		widgetSetColor(*form.ui.l_dcc_state, Qt::green);
-	} else if (s == Xn::TrkStatus::Off) {
-		form.ui.l_dcc_state->setText("OFF");
-		widgetSetColor(*form.ui.l_dcc_state, Qt::red);
-	} else if (s == Xn::TrkStatus::Programming) {
-		form.ui.l_dcc_state->setText("PROGRAM");
-		widgetSetColor(*form.ui.l_dcc_state, Qt::yellow);
-	} else {
-		form.ui.l_dcc_state->setText("???");
-		widgetSetColor(*form.ui.l_dcc_state, Qt::black);
-	}
+	this->publishOutputsRejected();
+	if (this->observer != nullptr)
+		this->observer->onTrkStatusChanged(s);
 
 	if (this->opening) {
 		if (s != Xn::TrkStatus::On) {
@@ -595,16 +954,22 @@ void RcsXn::xnOnTrkStatusChanged(Xn::TrkStatus s) {
 	}
 }
 
+void RcsXn::xn_onDccOpenError(void *, void *) {
+	log("No response on 'Set DCC' command!", RcsXnLogLevel::llError);
+	this->close();
+}
+
 void RcsXn::xnOnAccInputChanged(uint8_t groupAddr, bool nibble, bool error,
                                 Xn::FeedbackType inputType, Xn::AccInputsState state) {
 	(void)error; // ignoring errors reported by decoders
 	(void)inputType; // ignoring input type reported by decoder
 
-	if (s["global"]["addrRange"].toString() == "lenz") {
+	if (this->m_config.addrRange == AddrRange::lenz) {
 		// Lenz module 0 (bus) = module 1 (editation)
 		if (groupAddr == 255) {
-			log("Unsupported acc module (using Lenz addresses): " + QString::number(groupAddr),
-				RcsXnLogLevel::llWarning);
+			logLazy([groupAddr]() { return "Unsupported acc module (using Lenz addresses): " +
+			                               QString::number(groupAddr); },
+			        RcsXnLogLevel::llWarning);
 			return;
 		}
 		groupAddr++;
@@ -612,10 +977,12 @@ void RcsXn::xnOnAccInputChanged(uint8_t groupAddr, bool nibble, bool error,
 
 	this->modules_in[groupAddr].realActive = true;
 
-	if ((!this->modules_in[groupAddr].wantActive) && (form.ui.chb_scan_inputs->isChecked())) {
+	if ((!this->modules_in[groupAddr].wantActive) && (this->autoActivateInputs)) {
 		this->modules_in[groupAddr].wantActive = true;
-		this->twUpdateInputModule(groupAddr);
-		this->refreshActiveIOCounts();
+		this->m_dirty_modules.insert(groupAddr); // saved with next save
+		if (this->observer != nullptr)
+			this->observer->onModuleChanged(groupAddr);
+		this->inputModuleActiveChanged(groupAddr);
 	}
 
 	const bool states[4] = {state.sep.i0, state.sep.i1, state.sep.i2, state.sep.i3};
@@ -627,29 +994,36 @@ void RcsXn::xnOnAccInputChanged(uint8_t groupAddr, bool nibble, bool error,
 		if ((this->modules_in[groupAddr].state[port] == XnInState::on) && (!states[i]) &&
 		    (this->modules_in[groupAddr].inputFallDelays[port] > 0)) {
 			// input is falling -> start timer
-			this->modules_in[groupAddr].state[port] = XnInState::falling;
-			QTimer& fallTimer = this->modules_in[groupAddr].inputFallTimers[port];
-			fallTimer.stop();
-			fallTimer.start(this->modules_in[groupAddr].inputFallDelays[port]*100);
+			this->modules_in[groupAddr].state.set(port, XnInState::falling);
+			this->m_fallTimers.arm(groupAddr, port, this->modules_in[groupAddr].inputFallDelays[port]);
 			refreshTable = true;
 		} else {
 			if ((this->modules_in[groupAddr].state[port] != xnInState(states[i])) &&
 			    ((this->modules_in[groupAddr].state[port] != XnInState::falling) || (states[i]))) {
 				callChangeEvent = refreshTable = true;
-				this->modules_in[groupAddr].state[port] = xnInState(states[i]);
+				if (this->modules_in[groupAddr].state[port] == XnInState::falling)
+					this->m_fallTimers.cancel(groupAddr, port);
+				this->modules_in[groupAddr].state.set(port, xnInState(states[i]));
 			}
 		}
 	}
 
-	if ((this->started == RcsStartState::scanning) && (groupAddr == this->scan_group)) {
+	if (callChangeEvent)
+		this->updateInputsBitmap(groupAddr);
+	else
+		this->publishInput(groupAddr); // realActive/wantActive could have changed
+
+	if ((this->started == RcsStartState::scanning) && (this->m_scan_pending[groupAddr])) {
+		if ((callChangeEvent) && (this->m_input_provisional[groupAddr]))
+			events.call(events.onInputChanged, groupAddr); // provisional state was served
 		this->initModuleScanned(groupAddr, nibble);
 	} else {
 		if (callChangeEvent)
 			events.call(events.onInputChanged, groupAddr);
 	}
 
-	if (refreshTable)
-		this->twUpdateInputModuleInputs(groupAddr);
+	if ((refreshTable) && (this->observer != nullptr))
+		this->observer->onModuleInputsChanged(groupAddr);
 }
 
 void RcsXn::inputFellTimeout(unsigned module, unsigned port) {
@@ -657,11 +1031,83 @@ void RcsXn::inputFellTimeout(unsigned module, unsigned port) {
 		return;
 	if (this->modules_in[module].state[port] != XnInState::falling)
 		return; // do not fall if went high in meantime
-	this->log("Delayed fell: "+QString::number(module)+":"+QString::number(port), RcsXnLogLevel::llDebug);
+	this->logLazy([module, port]() {
+		return "Delayed fell: "+QString::number(module)+":"+QString::number(port);
+	}, RcsXnLogLevel::llDebug);
 
-	this->modules_in[module].state[port] = XnInState::off;
+	this->modules_in[module].state.set(port, XnInState::off);
+	this->updateInputsBitmap(module);
 	events.call(events.onInputChanged, module);
-	this->twUpdateInputModuleInputs(module);
+	if (this->observer != nullptr)
+		this->observer->onModuleInputsChanged(module);
+}
+
+void RcsXn::updateInputsBitmap(unsigned int module) {
+	uint8_t bitmap = 0;
+	for (unsigned i = 0; i < IO_IN_MODULE_PIN_COUNT; i++) {
+		const XnInState state = this->modules_in[module].state[i];
+		if ((state == XnInState::on) || (state == XnInState::falling))
+			bitmap |= (1 << i);
+	}
+	this->inputs_bitmap[module] = bitmap;
+	this->publishInput(module);
+}
+
+void RcsXn::publishInput(unsigned int module) {
+	InModuleState state;
+	state.inputs = this->inputs_bitmap[module];
+	state.wantActive = this->modules_in[module].wantActive;
+	state.realActive = this->modules_in[module].realActive;
+	state.provisional = this->m_input_provisional[module];
+	this->io.setIn(module, state);
+}
+
+OutModuleState RcsXn::outputState(unsigned int module) const {
+	static_assert(XN_SIGNAL_CODES_COUNT == OUT_SIGNAL_CODES_PUBLISHED, "Codes not published");
+	const bool lenz = (this->m_config.addrRange == AddrRange::lenz);
+	OutModuleState state;
+	for (unsigned int port = 0; port < IO_OUT_MODULE_PIN_COUNT; port++)
+		if (this->outputs[IO_OUT_MODULE_PIN_COUNT*module + port])
+			state.outputs |= (1 << port);
+	state.active = this->user_active_out[module];
+	state.binary = this->binary[module];
+	state.addrInvalid = (lenz) && (module == 0);
+	const auto signal = this->sig.find(module); // hJOP address of signal = output module
+	state.signal = (signal != this->sig.end());
+	if (state.signal) {
+		const XnSignal &xnSig = signal->second;
+		state.signalCode = xnSig.currentCode;
+		state.signalAddrInvalid = (lenz) && (xnSig.startAddr == 0);
+		if (xnSig.compiled != nullptr) {
+			for (unsigned int code = 0; code < XN_SIGNAL_CODES_COUNT; code++)
+				if (xnSig.compiled->aspect(code) != nullptr)
+					state.signalCodes |= (1u << code);
+			state.signalOtherCodes = !xnSig.compiled->otherAspects.empty();
+		}
+	}
+	return state;
+}
+
+void RcsXn::publishOutput(unsigned int module) {
+	if (module >= IO_OUT_MODULES_COUNT)
+		return;
+	this->io.setOut(module, this->outputState(module));
+}
+
+void RcsXn::outputWritten(unsigned int module) {
+	this->io.endOutWrite(module, this->outputState(module));
+}
+
+void RcsXn::publishOutputsRejected() {
+	this->io.setOutputsRejected((this->m_config.disableSetOutputOff) &&
+	                            (this->xn.getTrkStatus() != Xn::TrkStatus::On));
+}
+
+void RcsXn::publishIO() {
+	for (unsigned int module = 0; module < IO_IN_MODULES_COUNT; module++)
+		this->publishInput(module);
+	for (unsigned int module = 0; module < IO_OUT_MODULES_COUNT; module++)
+		this->publishOutput(module);
 }
 
 void RcsXn::xnOnLIVersionError(void *, void *) {
@@ -694,15 +1140,47 @@ void RcsXn::xnGotLIVersion(void *, unsigned hw, unsigned sw) {
 ///////////////////////////////////////////////////////////////////////////////
 // Signals
 
-void RcsXn::loadSignals(QSettings &s) {
+void RcsXn::loadSignals(const IniData &s) {
 	try {
-		this->sig = signalsFromFile(s);
+		this->sig = signalsFromFile(s, this->m_sig_cache);
 		this->sigTemplates = signalTemplatesFromFile(s);
 	} catch (const QStrException &e) {
 		this->log("Nepodařilo se načíst návěstidla: " + e.str(), RcsXnLogLevel::llError);
 		throw;
 	}
-	this->fillSignals();
+}
+
+void RcsXn::addSignal(XnSignal signal) {
+	if (this->sig.find(signal.hJOPaddr) != this->sig.end())
+		throw QStrException("Návěstidlo s touto hJOP adresou je již definováno!");
+	signal.compile(this->m_sig_cache);
+	this->sig.emplace(signal.hJOPaddr, signal);
+	this->m_dirty_signals.insert(signal.hJOPaddr);
+	this->publishOutput(signal.hJOPaddr);
+	this->configChanged();
+}
+
+void RcsXn::replaceSignal(unsigned int hJOPaddr, XnSignal signal) {
+	if ((signal.hJOPaddr != hJOPaddr) && (this->sig.find(signal.hJOPaddr) != this->sig.end()))
+		throw QStrException("Návěstidlo s touto hJOP adresou je již definováno!");
+	if (this->sig.find(hJOPaddr) != this->sig.end()) {
+		this->sig.erase(hJOPaddr);
+		this->m_dirty_signals.insert(hJOPaddr);
+	}
+	signal.compile(this->m_sig_cache);
+	signal.outputsState.clear(); // outputs could have changed
+	this->sig.emplace(signal.hJOPaddr, signal);
+	this->m_dirty_signals.insert(signal.hJOPaddr);
+	this->publishOutput(hJOPaddr);
+	this->publishOutput(signal.hJOPaddr);
+	this->configChanged();
+}
+
+void RcsXn::removeSignal(unsigned int hJOPaddr) {
+	this->sig.erase(hJOPaddr);
+	this->m_dirty_signals.insert(hJOPaddr);
+	this->publishOutput(hJOPaddr);
+	this->configChanged();
 }
 
 void RcsXn::saveSignals(QSettings &s) const {
@@ -719,58 +1197,90 @@ void RcsXn::saveSignals(QSettings &s) const {
 	signalTmplsToFile(s, this->sigTemplates);
 }
 
+void RcsXn::saveSignalsChanges(QSettings &s) const {
+	for (unsigned int hJOPaddr : this->m_dirty_signals) {
+		s.beginGroup("Signal-" + QString::number(hJOPaddr));
+		s.remove("");
+		const auto it = this->sig.find(hJOPaddr);
+		if (it != this->sig.end())
+			it->second.saveData(s);
+		s.endGroup();
+	}
+
+	// Templates are edited in signal dialog directly -> compare with last saved state
+	for (const auto &saved : this->m_saved_templates) {
+		if (this->sigTemplates.find(saved.first) == this->sigTemplates.end()) {
+			s.beginGroup("SigTemplate-" + saved.first);
+			s.remove("");
+			s.endGroup();
+		}
+	}
+	for (const auto &tmpl : this->sigTemplates) {
+		const auto saved = this->m_saved_templates.find(tmpl.first);
+		if ((saved == this->m_saved_templates.end()) || (saved->second != tmpl.second)) {
+			s.beginGroup("SigTemplate-" + tmpl.first);
+			s.remove("");
+			tmpl.second.saveData(s);
+			s.endGroup();
+		}
+	}
+}
+
 bool RcsXn::isSignal(unsigned int portAddr) const {
 	return ((!(portAddr&1)) && (this->sig.find(portAddr >> 1) != this->sig.end()));
 }
 
-int RcsXn::setSignal(unsigned int portAddr, unsigned int code) {
+int RcsXn::setSignal(unsigned int portAddr, unsigned int code, bool force) {
 	int retval = 0;
 	XnSignal &sig = this->sig.at(portAddr/IO_OUT_MODULE_PIN_COUNT);
 	sig.currentCode = code;
+	this->publishOutput(sig.hJOPaddr);
 	if (code < XnSignalCodes.size())
-		log(sig.name + ":  " + XnSignalCodes[code], RcsXnLogLevel::llCommands);
-	rx.events.call(rx.events.onOutputChanged, sig.hJOPaddr);
+		logLazy([&sig, code]() { return sig.name + ":  " + XnSignalCodes[code]; },
+		        RcsXnLogLevel::llCommands);
+	this->outputChanged(sig.hJOPaddr);
 
-	if (sig.tmpl.outputs.find(code) == sig.tmpl.outputs.end()) {
+	if (sig.compiled == nullptr)
+		sig.compile(this->m_sig_cache);
+
+	const CompactAspect *aspect = sig.compiled->aspect(code);
+	if (aspect == nullptr) {
 		if (code < XnSignalCodes.size())
 			log(sig.name + ": kódu návěsti " + XnSignalCodes[code] +
 				" není přiřazen žádný návěstní znak.", RcsXnLogLevel::llWarning);
 		return RCS_INVALID_SCOM_CODE;
 	}
-	QString outputs = sig.tmpl.outputs.at(code);
 
-	for (size_t i = 0; i < std::min(sig.tmpl.outputsCount, static_cast<std::size_t>(outputs.length())); i++) {
-		QChar state = outputs[static_cast<int>(i)];
-		if (state == 'N')
+	// Only outputs with state different from last commanded state are sent (unless forced)
+	if (sig.outputsState.size() < aspect->outputs.size())
+		sig.outputsState.resize(aspect->outputs.size(), 0);
+
+	const unsigned int firstPort = 2*sig.startAddr;
+	const OutputPriority priority = (code == 0) ? OutputPriority::stop : OutputPriority::signal;
+	size_t output = aspect->outputs.size();
+	bool skip = false;
+	for (const AspectCmd &cmd : aspect->cmds) {
+		if (cmd.portOffset/2 != output) {
+			output = cmd.portOffset/2;
+			skip = (!force) && (sig.outputsState[output] == aspect->outputs[output]);
+			sig.outputsState[output] = aspect->outputs[output];
+		}
+		if (skip)
 			continue;
 
-		const unsigned int module = sig.startAddr+i;
-		int subret = 0;
-
-		if (state == '+') {
-			subret = this->setPlainOutput(2*module + 1, true, false);
-		} else if (state == '-') {
-			subret = this->setPlainOutput(2*module, true, false);
-		} else if (state == '0') {
-			subret = this->setPlainOutput(2*module, false, false);
-			if (subret != 0 && retval == 0)
+		const int subret = this->setPlainOutput(firstPort + cmd.portOffset, cmd.state, false, priority);
+		if (subret != 0) {
+			sig.outputsState[output] = 0; // state of decoder unknown
+			if (retval == 0)
 				retval = subret;
-			subret = this->setPlainOutput(2*module + 1, false, false);
-		} else if (state == '1') {
-			subret = this->setPlainOutput(2*module, true, false);
-			if (subret != 0 && retval == 0)
-				retval = subret;
-			subret = this->setPlainOutput(2*module + 1, true, false);
 		}
-		if (subret != 0 && retval == 0)
-			retval = subret;
 	}
 
 	return retval;
 }
 
 bool RcsXn::isResettingSignals() const {
-	return this->m_resetSignalsTimer.isActive();
+	return this->m_resetSignalsActive;
 }
 
 void RcsXn::resetSignals() {
@@ -778,43 +1288,67 @@ void RcsXn::resetSignals() {
 		return;
 
 	log("Nastavuji návěstidla na stůj...", RcsXnLogLevel::llInfo);
+	this->m_resetSignalsActive = true;
 	this->m_resetSignalsIt = this->sig.begin();
-	this->m_resetSignalsTimer.start();
+	this->m_resetSignalsDone = 0;
+	this->events.call(this->events.onSignalsResetProgress, 0, this->sig.size());
 
-	this->resetNextSignal();
+	this->resetNextSignals();
 }
 
-void RcsXn::resetNextSignal() {
+void RcsXn::resetNextSignals() {
+	// Called on start of reset and on completion of each output command, so signals are reset
+	// as fast as the command station accepts commands, not faster.
 	if (!this->isResettingSignals())
 		return;
 
-	if (this->m_resetSignalsIt == this->sig.end() || !this->xn.connected()) {
-		this->m_resetSignalsTimer.stop();
-		log("Návěstidla nastavena na stůj.", RcsXnLogLevel::llInfo);
+	if (!this->xn.connected()) {
+		this->m_resetSignalsActive = false;
 		return;
 	}
 
-	while (this->m_resetSignalsIt->second.currentCode != 0 && this->m_resetSignalsIt != this->sig.end())
+	const unsigned int doneBefore = this->m_resetSignalsDone;
+	while ((this->m_resetSignalsIt != this->sig.end()) &&
+	       (this->outputsPending() < SIGNAL_RESET_MAX_PENDING)) {
+		// Signals already set by hJOP are not reset; aspect restored from snapshot is not verified
+		if (!this->m_resetSignalsIt->second.setByHost)
+			this->setSignal(this->m_resetSignalsIt->first * IO_OUT_MODULE_PIN_COUNT, 0, true);
 		++this->m_resetSignalsIt;
+		++this->m_resetSignalsDone;
+	}
 
-	if (this->m_resetSignalsIt != this->sig.end()) {
-		this->setSignal(this->m_resetSignalsIt->second.startAddr * IO_OUT_MODULE_PIN_COUNT, 0);
-		++this->m_resetSignalsIt;
+	if (this->m_resetSignalsDone != doneBefore)
+		this->events.call(this->events.onSignalsResetProgress, this->m_resetSignalsDone,
+		                  this->sig.size());
+
+	if ((this->m_resetSignalsIt == this->sig.end()) && (this->outputsPending() == 0)) {
+		this->m_resetSignalsActive = false;
+		log("Návěstidla nastavena na stůj.", RcsXnLogLevel::llInfo);
 	}
 }
 
 void RcsXn::resetIOState() {
-	std::fill(this->outputs.begin(), this->outputs.end(), false);
+	this->outputs.reset();
 	for (unsigned addr = 0; addr < IO_IN_MODULES_COUNT; addr++) {
-		for (auto& state : this->modules_in[addr].state)
-			state = XnInState::unknown;
-		this->twUpdateInputModuleInputs(addr);
+		this->modules_in[addr].state.fill(XnInState::unknown);
+		if (this->observer != nullptr)
+			this->observer->onModuleInputsChanged(addr);
 	}
-	for (auto &signal : this->sig)
+	std::fill(this->inputs_bitmap.begin(), this->inputs_bitmap.end(), 0);
+	this->m_input_provisional.reset();
+	for (auto &signal : this->sig) {
 		signal.second.currentCode = 0;
+		signal.second.setByHost = false;
+		signal.second.outputsState.clear();
+	}
 	std::fill(this->m_accToResetArr.begin(), this->m_accToResetArr.end(), 0);
 	this->m_accToResetDeq.clear();
+	this->m_acc_reset_timer.stop();
+	this->m_resetSignalsActive = false;
 	this->m_acc_op_pending_count = 0;
+	this->m_outputs_queue.clear();
+	this->m_outputs_starve_timer.stop();
+	this->publishIO();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -831,8 +1365,8 @@ Xn::LIType RcsXn::interface(const QString &name) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-uint8_t RcsXn::inBusModuleAddr(uint8_t userAddr) {
-	if (s["global"]["addrRange"].toString() == "lenz") {
+uint8_t RcsXn::inBusModuleAddr(uint8_t userAddr) const {
+	if (this->m_config.addrRange == AddrRange::lenz) {
 		if (userAddr == 0)
 			return 0;
 		return userAddr - 1;
@@ -842,41 +1376,122 @@ uint8_t RcsXn::inBusModuleAddr(uint8_t userAddr) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+RuntimeConfig RuntimeConfig::fromSettings(Settings &s) {
+	RuntimeConfig config;
+	config.addrRange = (s["global"]["addrRange"].toString() == "lenz") ? AddrRange::lenz
+	                                                                   : AddrRange::basic;
+	config.resetSignals = s["global"]["resetSignals"].toBool();
+	config.mockInputs = s["global"]["mockInputs"].toBool();
+	config.disableSetOutputOff = s["global"]["disableSetOutputOff"].toBool();
+	config.outputCoalesceMs = s["XN"]["outputCoalesceMs"].toUInt();
+	config.warmRestart = s["global"]["warmRestart"].toBool();
+	config.warmRestartMaxAge = s["global"]["warmRestartMaxAge"].toUInt();
+	return config;
+}
+
+void RcsXn::refreshRuntimeConfig() {
+	const AddrRange addrRange = this->m_config.addrRange;
+	this->m_config = RuntimeConfig::fromSettings(this->s);
+	this->publishOutputsRejected();
+	if (this->m_config.addrRange != addrRange)
+		this->publishIO(); // validity of addresses
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void RcsXn::m_acc_reset_timer_tick() {
-	/* Only reset of last set-output command should be performed.
-	 * But only in situation, when acc command is not pending (because reset would cancel pending set-output)!
+	/* Reset all outputs with reached reset time. Reset is skipped when another
+	 * set-output command was performed on the port in meantime (id differs).
 	 */
 
-	while ((!this->m_accToResetDeq.empty()) && (QDateTime::currentDateTime() >= this->m_accToResetDeq.front().resetTime)) {
+	const qint64 now = m_clock.elapsed();
+	while ((!this->m_accToResetDeq.empty()) && (now >= this->m_accToResetDeq.front().resetTime)) {
 		const AccReset reset = std::move(this->m_accToResetDeq.front());
 		this->m_accToResetDeq.pop_front();
 
 		if (reset.id == this->m_accToResetArr[reset.portAddr]) {
 			m_accToResetArr[reset.portAddr] = 0;
-			if (this->m_accToResetDeq.empty()) {
-				this->setPlainOutput(reset.portAddr, 0, false);
-			}
+			this->setPlainOutput(reset.portAddr, 0, false, OutputPriority::reset);
 		}
 	}
+
+	this->accResetSchedule();
+}
+
+void RcsXn::m_outputs_starve_timer_tick() {
+	this->outputsSend();
+}
+
+void RcsXn::accResetSchedule() {
+	// Timer is armed for the earliest reset only
+	if ((this->m_accToResetDeq.empty()) || (this->m_acc_reset_timer.isActive()))
+		return;
+	const qint64 remaining = this->m_accToResetDeq.front().resetTime - m_clock.elapsed();
+	this->m_acc_reset_timer.start(static_cast<int>(std::max<qint64>(remaining, 0)));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void RcsXn::inputModuleEdited(unsigned int addr, const RcsInputModule &edited) {
+	// Copy of the module was edited in GUI, state of the module is kept
+	RcsInputModule &module = this->modules_in[addr];
+	module.name = edited.name;
+	module.wantActive = edited.wantActive;
+	module.inputFallDelays = edited.inputFallDelays;
+
+	this->inputModuleActiveChanged(addr);
+	this->m_dirty_modules.insert(addr);
+	this->events.call(this->events.onModuleChanged, addr);
+	this->configChanged();
+}
+
 void RcsXn::refreshActiveIOCounts() {
-	this->modules_count = this->in_count = this->out_count = 0;
-	for (RcsInputModule& module : this->modules_in)
-		if (module.wantActive)
-			this->in_count++;
-	for (bool active : this->user_active_out)
-		if (active)
-			this->out_count++;
-	for (size_t i = 0; i < std::max(IO_IN_MODULES_COUNT, IO_OUT_MODULES_COUNT); i++)
-		if ((i < IO_IN_MODULES_COUNT && this->modules_in[i].wantActive) ||
-		    (i < IO_OUT_MODULES_COUNT && this->user_active_out[i]))
+	// Full recount, used only after bulk changes (loading config, editing active outputs)
+	for (size_t i = 0; i < IO_IN_MODULES_COUNT; i++)
+		this->m_active_in.set(i, this->modules_in[i].wantActive);
+
+	this->in_count = static_cast<unsigned int>(this->m_active_in.count());
+	this->out_count = static_cast<unsigned int>(this->user_active_out.count());
+	this->modules_count = static_cast<unsigned int>((this->m_active_in | this->user_active_out).count());
+	this->publishIO();
+
+	this->activeIOCountsChanged();
+}
+
+void RcsXn::inputModuleActiveChanged(unsigned int addr) {
+	// Called after wantActive of single input module could have changed
+	this->publishInput(addr);
+	const bool active = this->modules_in[addr].wantActive;
+	if (this->m_active_in[addr] == active)
+		return;
+	this->m_active_in.set(addr, active);
+
+	if (active) {
+		this->in_count++;
+		if (!this->user_active_out[addr])
 			this->modules_count++;
+	} else {
+		this->in_count--;
+		if (!this->user_active_out[addr])
+			this->modules_count--;
+	}
+
+	this->activeIOCountsChanged();
+}
+
+void RcsXn::activeIOCountsChanged() {
+#ifndef QT_NO_DEBUG
+	// Incrementally maintained counts must match full recount
+	BitArray<IO_OUT_MODULES_COUNT> active_in;
+	for (size_t i = 0; i < IO_IN_MODULES_COUNT; i++)
+		active_in.set(i, this->modules_in[i].wantActive);
+	Q_ASSERT(this->in_count == active_in.count());
+	Q_ASSERT(this->out_count == this->user_active_out.count());
+	Q_ASSERT(this->modules_count == (active_in | this->user_active_out).count());
+#endif
 
-	this->form.ui.l_in_count->setText(QString::number(this->in_count));
-	this->form.ui.l_out_count->setText(QString::number(this->out_count));
+	if (this->observer != nullptr)
+		this->observer->onActiveIOCountsChanged();
 }
 
 } // namespace RcsXn
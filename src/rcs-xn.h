@@ -6,39 +6,39 @@
  */
 
 #include <QCoreApplication>
-#include <QMainWindow>
+#include <QElapsedTimer>
 #include <QThread>
 #include <QtCore/QtGlobal>
 #include <QtGlobal>
 #include <QTimer>
 #include <array>
+#include <atomic>
 #include <map>
 #include <queue>
+#include <set>
+#include <vector>
 
+#include "bit-array.h"
 #include "common.h"
 #include "events.h"
-#include "form-signal-edit.h"
+#include "io-state.h"
+#include "fall-timer-wheel.h"
+#include "log-sink.h"
+#include "range-codec.h"
+#include "output-queue.h"
 #include "lib/q-str-exception.h"
 #include "lib/xn-lib-cpp-qt/xn.h"
+#include "rcs-xn-observer.h"
 #include "settings.h"
 #include "signals.h"
-#include "ui_main-window.h"
+#include "snapshot.h"
 #include "rcsinputmodule.h"
-#include "form-in-module-edit.h"
 
-namespace RcsXn {
-
-constexpr int MAX_LOGTABLE_ITEMS = 300;
+#ifndef RCS_XN_HEADLESS
+#include <QApplication>
+#endif
 
-enum class RcsXnLogLevel {
-	llNo = 0,
-	llError = 1,
-	llWarning = 2,
-	llInfo = 3,
-	llCommands = 4,
-	llRawCommands = 5,
-	llDebug = 6,
-};
+namespace RcsXn {
 
 enum class RcsStartState {
 	stopped = 0,
@@ -46,28 +46,48 @@ enum class RcsStartState {
 	started = 2,
 };
 
+enum class AddrRange {
+	basic = 0,
+	lenz = 1,
+};
+
+/* Typed copy of runtime-relevant settings. Hot paths (setting outputs,
+ * processing feedback) read this instead of looking strings up in Settings.
+ * It is rebuilt only when settings change (see RcsXn::refreshRuntimeConfig).
+ */
+struct RuntimeConfig {
+	AddrRange addrRange = AddrRange::basic;
+	bool resetSignals = false;
+	bool mockInputs = false;
+	bool disableSetOutputOff = false;
+	unsigned int outputCoalesceMs = 0;
+	bool warmRestart = false;
+	unsigned int warmRestartMaxAge = 0; // s, 0 = no limit
+
+	static RuntimeConfig fromSettings(Settings &);
+};
+
 struct EInvalidRange : public QStrException {
 	EInvalidRange(const QString &str) : QStrException(str) {}
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class MainWindow : public QMainWindow {
-	Q_OBJECT
-public:
-	Ui::MainWindow ui;
-	MainWindow(QWidget *parent = nullptr) : QMainWindow(parent) { ui.setupUi(this); }
+struct OutputCmd {
+	unsigned int module; // 0-1023
+	unsigned int port; // 0-1
+	int state;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 struct AccReset {
-	AccReset(unsigned int id, unsigned int portAddr, QDateTime resetTime)
+	AccReset(unsigned int id, unsigned int portAddr, qint64 resetTime)
 		: id(id), portAddr(portAddr), resetTime(resetTime) {}
 
 	unsigned int id;
 	unsigned int portAddr;
-	QDateTime resetTime;
+	qint64 resetTime; // [ms] of RcsXn::m_clock
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -79,38 +99,46 @@ public:
 	RcsEvents events;
 	Xn::XpressNet xn;
 	Settings s;
-	RcsXnLogLevel loglevel = RcsXnLogLevel::llInfo;
-	RcsStartState started = RcsStartState::stopped;
-	bool opening = false;
+	RcsXnLogLevel loglevel = RcsXnLogLevel::llInfo; // GUI log table
+	RcsXnLogLevel loglevel_host = RcsXnLogLevel::llDebug; // onLog event
+	// Atomic members could be read from any thread (lock-free API state queries)
+	std::atomic<RcsStartState> started {RcsStartState::stopped};
+	std::atomic<bool> opening {false};
+	std::atomic<bool> connected {false}; // mirror of xn.connected() set in XN events
 	std::array<RcsInputModule, IO_IN_MODULES_COUNT> modules_in;
-	std::array<bool, IO_COUNT> outputs;
-	std::array<bool, IO_OUT_MODULES_COUNT> user_active_out; // 0-1023
-	std::array<bool, IO_OUT_MODULES_COUNT> binary; // 0-1023
-	uint8_t scan_group;
+	std::array<uint8_t, IO_IN_MODULES_COUNT> inputs_bitmap; // bit n = input n of module is on
+	BitArray<IO_COUNT> outputs;
+	BitArray<IO_OUT_MODULES_COUNT> user_active_out; // 0-1023
+	BitArray<IO_OUT_MODULES_COUNT> binary; // 0-1023
 	QString config_filename = "";
 	unsigned int li_ver_hw = 0, li_ver_sw = 0;
-	unsigned int modules_count = 0;
+	std::atomic<unsigned int> modules_count {0};
+	IoState io; // published copy of I/O state for lock-free reading from any thread
 	unsigned int in_count = 0, out_count = 0;
 
 	// signals
 	SigTmplStorage sigTemplates;
 	SigStorage sig;
 
-	// UI
-	MainWindow form;
-	SignalEdit::FormSignalEdit f_signal_edit;
-	FormInModuleEdit f_module_edit;
-	bool gui_config_changing = false;
+	RcsXnObserver *observer = nullptr; // GUI, nullptr in headless build
+	bool autoActivateInputs = false; // input module sending feedback is marked as active
 
 	explicit RcsXn(QObject *parent = nullptr);
 	~RcsXn() override;
 
 	void log(const QString &msg, RcsXnLogLevel loglevel);
+	bool logEnabled(RcsXnLogLevel loglevel) const;
+	template <typename F>
+	void logLazy(F &&msg, RcsXnLogLevel loglevel); // msg() is called only when logged
 	void error(const QString &message, uint16_t code, unsigned int module);
 	void error(const QString &message, uint16_t code);
 	void error(const QString &message);
 	void first_scan();
 	void setLogLevel(RcsXnLogLevel);
+	void setHostLogLevel(RcsXnLogLevel);
+	void refreshLogLevel();
+	void setLogAsync(bool enabled, size_t capacity, LogDropPolicy policy);
+	uint64_t logDroppedCount() const { return this->m_log_sink.dropped(); }
 
 	int openDevice(const QString &device, bool persist);
 	int close();
@@ -120,13 +148,35 @@ public:
 	int start();
 	int stop();
 
-	int setPlainOutput(unsigned int portAddr, int state, bool setInternalState = true);
+	int setOutput(unsigned int module, unsigned int port, int state); // expects validated module & port
+	int setOutputs(const std::vector<OutputCmd> &cmds); // expects validated modules & ports
+	int setPlainOutput(unsigned int portAddr, int state, bool setInternalState = true,
+	                   OutputPriority priority = OutputPriority::plain);
+	void outputWritten(unsigned int module); // write begun by IoState::beginOutWrite performed
 	void xnSetOutputOk(unsigned int portAddr, int state);
-	void xnSetOutputError(unsigned int module);
+	void xnSetOutputError(unsigned int portAddr);
+
+	void updateInputsBitmap(unsigned int module);
 
 	bool isSignal(unsigned int portAddr) const; // 0-2047
-	int setSignal(unsigned int portAddr, unsigned int code); // returns same error codes as SetOutput
+	// returns same error codes as SetOutput; force = send all outputs, even in already set state
+	int setSignal(unsigned int portAddr, unsigned int code, bool force = false);
 	bool isResettingSignals() const;
+	// module state comes from snapshot of previous run, not verified by scan yet
+	bool inputProvisional(unsigned int module) const { return this->m_input_provisional[module]; }
+
+	// Configuration changes from GUI, saved to config file with delay
+	void addSignal(XnSignal); // throws QStrException
+	void replaceSignal(unsigned int hJOPaddr, XnSignal); // throws QStrException
+	void removeSignal(unsigned int hJOPaddr);
+	void inputModuleEdited(unsigned int addr, const RcsInputModule &edited); // configuration only
+	void setActiveIO(const QString &outputs, const QString &binary); // throws QStrException
+
+	const RuntimeConfig &config() const { return this->m_config; }
+	void refreshRuntimeConfig();
+	const OutputQueueStats &outputQueueStats(OutputPriority priority) const {
+		return this->m_outputs_queue.stats(priority);
+	}
 
 private slots:
 	void xnOnError(QString error);
@@ -137,107 +187,120 @@ private slots:
 	void xnOnAccInputChanged(uint8_t groupAddr, bool nibble, bool error, Xn::FeedbackType inputType,
 	                         Xn::AccInputsState state);
 
-	void resetNextSignal();
-
 	void m_acc_reset_timer_tick();
+	void m_outputs_starve_timer_tick();
+	void m_save_timer_tick();
+	void m_snapshot_timer_tick();
 	void inputFellTimeout(unsigned module, unsigned port);
 
-	// GUI
-	void cb_loglevel_changed(int);
-	void cb_interface_type_changed(int);
-	void cb_connections_changed(int);
-	void b_serial_refresh_handle();
-	void b_active_outputs_load_handle();
-	void b_active_outputs_save_handle();
-	void tw_log_double_clicked(QTreeWidgetItem *item, int column);
-	void b_signal_add_handle();
-	void b_signal_remove_handle();
-	void tw_signals_dbl_click(QTreeWidgetItem *, int);
-	void tw_signals_selection_changed();
-	void chb_general_config_changed(int state);
-	void b_dcc_on_handle();
-	void b_dcc_off_handle();
-	void tw_input_modules_dbl_click(QTreeWidgetItem *, int);
-	void f_module_edit_accepted();
-
 private:
-	unsigned int m_acc_op_pending_count = 0;
+	RuntimeConfig m_config;
+	AsyncLogSink m_log_sink;
+	unsigned int m_acc_op_pending_count = 0; // commands handed to XN library
+	OutputQueue m_outputs_queue;
+	bool m_outputs_batch = false;
+	std::array<bool, IO_OUT_MODULES_COUNT> m_outputs_batch_changed;
+	QElapsedTimer m_clock;
+	QTimer m_outputs_starve_timer;
 	QTimer m_acc_reset_timer;
-	std::deque<AccReset> m_accToResetDeq;
+	std::deque<AccReset> m_accToResetDeq; // ordered by resetTime
 	std::array<unsigned int, IO_COUNT> m_accToResetArr;
-	QTimer m_resetSignalsTimer;
+	FallTimerWheel m_fallTimers;
+	// mirror of modules_in[].wantActive (sized as outputs for counting modules with both)
+	BitArray<IO_OUT_MODULES_COUNT> m_active_in;
+
+	// initial scan
+	std::array<bool, IO_IN_MODULES_COUNT> m_scan_pending;
+	std::array<uint8_t, IO_IN_MODULES_COUNT> m_scan_nibbles; // bit 0 = nibble 0, bit 1 = nibble 1
+	std::array<uint8_t, IO_IN_MODULES_COUNT> m_scan_retries;
+	unsigned m_scan_next = 0;
+	unsigned m_scan_in_flight = 0;
+	unsigned m_scan_window = 1;
+	unsigned m_scan_generation = 0;
+
+	// config persistence
+	QTimer m_save_timer;
+	bool m_save_all = true; // config file does not correspond to any loaded config
+	std::set<unsigned int> m_dirty_signals; // hJOP addresses
+	std::set<unsigned int> m_dirty_modules; // input modules
+	SigTmplStorage m_saved_templates;
+
+	// warm restart
+	QTimer m_snapshot_timer;
+	BitArray<IO_IN_MODULES_COUNT> m_input_provisional;
+
+	SigTemplateCache m_sig_cache; // compiled templates of signals in sig
+
+	// signals reset
+	bool m_resetSignalsActive = false;
 	SigStorage::iterator m_resetSignalsIt;
+	unsigned int m_resetSignalsDone = 0;
 
 	void xnGotLIVersion(void *, unsigned hw, unsigned sw);
 	void xnOnLIVersionError(void *, void *);
 	void xnOnCSStatusError(void *, void *);
-	void xnOnInitScanningError(void *, void *);
+	void xnOnInitScanningError(unsigned group, bool nibble, unsigned generation);
 	void xn_onDccError(void *, void *);
 	void xn_onDccOpenError(void *, void *);
 	void initModuleScanned(uint8_t group, bool nibble);
-	void scanNextGroup(int previousGroup);
+	unsigned scanWindow();
+	void scanFill();
+	void scanRequestGroup(unsigned group);
+	void scanRequestNibble(unsigned group, bool nibble);
+	void scanGroupDone(unsigned group);
 	void initScanningDone();
 	Xn::LIType interface(const QString &name) const;
-	uint8_t inBusModuleAddr(uint8_t userAddr);
-
-	template <std::size_t ArraySize>
-	void parseModules(const QString &active, std::array<bool, ArraySize> &result,
-	                  bool except = true);
+	uint8_t inBusModuleAddr(uint8_t userAddr) const;
+	bool hostLogDefined() const;
+	void hostLog(int loglevel, const QString &msg) const;
+	AsyncLogSink::Deliver hostLogDeliver() const; // delivery of batches in sink thread
+	void outputChanged(unsigned int module);
+	void publishInput(unsigned int module);
+	OutModuleState outputState(unsigned int module) const;
+	void publishOutput(unsigned int module);
+	void publishOutputsRejected();
+	void publishIO();
+	void accResetSchedule();
+	void outputsSend();
+	size_t outputsPending() const; // queued + handed to XN library
 
 	template <std::size_t ArraySize>
-	QString getActiveStr(const std::array<bool, ArraySize> &source, const QString &separator);
+	void parseModules(const QString &active, BitArray<ArraySize> &result, bool except = true);
 
 	void loadActiveIO(const QString &inputs, const QString &outputs, bool except = true);
 	void resetIOState();
 
-	void loadSignals(QSettings &s);
+	void writeConfig(const QString &filename, bool all);
+	void configChanged();
+
+	QString snapshotFilename() const;
+	void saveSnapshot();
+	void loadSnapshot();
+	void provisionalInputDone(unsigned int module);
+
+	void loadSignals(const IniData &s);
 	void saveSignals(QSettings &s) const;
+	void saveSignalsChanges(QSettings &s) const;
 
-	void loadInputModules(QSettings &s);
+	void loadInputModules(const IniData &s);
 	void saveInputModules(QSettings &s) const;
+	void saveInputModulesChanges(QSettings &s) const;
 
-	unsigned int current_editing_signal;
-	void newSignal(XnSignal);
-	void editedSignal(XnSignal);
 	void resetSignals();
+	void resetNextSignals();
 
-	void setDcc(Xn::TrkStatus);
-	void widgetSetColor(QWidget &widget, const QColor &color);
-
-	// GUI:
-	void guiInit();
-	void fillConnectionsCbs();
-	void fillPortCb();
-	void guiOnOpen();
-	void guiOnClose();
-	void fillActiveOutputs();
-	void fillSignals();
-	void guiAddSignal(const XnSignal &);
-	void twFillInputModules();
-	void twUpdateInputModule(unsigned addr);
-	void twUpdateInputModuleInputs(unsigned addr);
 	void refreshActiveIOCounts();
+	void inputModuleActiveChanged(unsigned int addr);
+	void activeIOCountsChanged();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Templated method must be in header file
 
-template <std::size_t ArraySize>
-QString RcsXn::getActiveStr(const std::array<bool, ArraySize> &source, const QString &separator) {
-	QString output;
-	for (size_t start = 0; start < source.size(); ++start) {
-		if (source[start]) {
-			size_t end = start;
-			while (source[end] && end < source.size())
-				++end;
-			if (end == start+1)
-				output += QString::number(start)+separator;
-			else
-				output += QString::number(start)+"-"+QString::number(end-1)+separator;
-			start = end;
-		}
-	}
-	return output;
+template <typename F>
+void RcsXn::logLazy(F &&msg, RcsXnLogLevel loglevel) {
+	if (this->logEnabled(loglevel))
+		this->log(msg(), loglevel);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -248,7 +311,11 @@ struct AppThread {
 	AppThread() {
 		if (qApp == nullptr) {
 			int argc = 0;
+#ifdef RCS_XN_HEADLESS
+			QCoreApplication* app = new QCoreApplication(argc, nullptr);
+#else
 			QApplication* app = new QApplication(argc, nullptr);
+#endif
 			QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
 			app->exec();
 		}
@@ -256,8 +323,11 @@ struct AppThread {
 
 };
 
+class XnThread;
+
 extern AppThread main_thread;
-extern RcsXn rx;
+extern XnThread &xn_thread;
+extern RcsXn &rx; // lives in xn_thread, access it from other threads via xn_thread.call
 
 } // namespace RcsXn
 
@@ -2,23 +2,18 @@
 
 namespace RcsXn {
 
-RcsInputModule::RcsInputModule() {
-	for (QTimer& timer : this->inputFallTimers)
-		timer.setSingleShot(true);
-}
-
 QString RcsInputModule::fallDelayToStr(unsigned fallDelay) {
 	return QString::number(fallDelay/10) + "." + QString::number(fallDelay%10);
 }
 
-void RcsInputModule::load(const QSettings& s, unsigned addr) {
+void RcsInputModule::load(const IniSection& s, unsigned addr) {
 	this->addr = addr;
 	this->name = s.value("name", this->defaultName()).toString();
 	this->wantActive = s.value("active", false).toBool();
 	for (unsigned i = 0; i < IO_IN_MODULE_PIN_COUNT; i++) {
 		const QString fallDelay = s.value("fallDelay"+QString::number(i+1), "0.0").toString();
 		if (fallDelay.length() >= 3)
-			this->inputFallDelays[i] = (QString(fallDelay[0]) + QString(fallDelay[2])).toInt();
+			this->inputFallDelays[i] = static_cast<uint8_t>((QString(fallDelay[0]) + QString(fallDelay[2])).toUInt());
 		else
 			this->inputFallDelays[i] = 0;
 	}
@@ -57,23 +52,14 @@ bool RcsInputModule::allDefaults() const {
 	return true;
 }
 
-void RcsInputModule::stopAllFallTimers() {
-	for (QTimer& timer : this->inputFallTimers)
-		timer.stop();
-}
-
-void RcsXn::loadInputModules(QSettings &s) {
+void RcsXn::loadInputModules(const IniData &s) {
 	try {
-		for (unsigned i = 0; i < IO_IN_MODULES_COUNT; i++) {
-			s.beginGroup("InModule-"+QString::number(i));
-			this->modules_in[i].load(s, i);
-			s.endGroup();
-		}
+		for (unsigned i = 0; i < IO_IN_MODULES_COUNT; i++)
+			this->modules_in[i].load(s.section("InModule-"+QString::number(i)), i);
 	} catch (const QStrException &e) {
 		this->log("Nepodařilo se načíst vstupní moduly: " + e.str(), RcsXnLogLevel::llError);
 		throw;
 	}
-	this->twFillInputModules();
 	this->refreshActiveIOCounts();
 }
 
@@ -89,4 +75,16 @@ void RcsXn::saveInputModules(QSettings &s) const {
 	}
 }
 
+void RcsXn::saveInputModulesChanges(QSettings &s) const {
+	s.beginGroup("modules");
+	s.remove("active-in");
+	s.endGroup();
+
+	for (unsigned addr : this->m_dirty_modules) {
+		s.beginGroup("InModule-"+QString::number(addr));
+		this->modules_in[addr].save(s);
+		s.endGroup();
+	}
+}
+
 } // namespace RcsXn
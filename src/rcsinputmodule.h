@@ -2,28 +2,47 @@
 #define RCSINPUTMODULE_H
 
 #include "common.h"
+#include "ini-data.h"
 #include <QSettings>
-#include <QTimer>
+#include <array>
 
 namespace RcsXn {
 
+// States of all pins of a module, 2 bits per pin
+class InStates {
+public:
+	XnInState operator[](size_t pin) const {
+		return static_cast<XnInState>((this->m_bits >> (2*pin)) & 0x3);
+	}
+	void set(size_t pin, XnInState state) {
+		this->m_bits = static_cast<uint16_t>((this->m_bits & ~(0x3 << (2*pin))) |
+		                                     (static_cast<unsigned>(state) << (2*pin)));
+	}
+	void fill(XnInState state) {
+		this->m_bits = static_cast<uint16_t>(0x5555 * static_cast<unsigned>(state));
+	}
+	constexpr size_t size() const { return IO_IN_MODULE_PIN_COUNT; }
+	uint16_t raw() const { return this->m_bits; }
+	void setRaw(uint16_t bits) { this->m_bits = bits; }
+
+private:
+	static_assert(IO_IN_MODULE_PIN_COUNT*2 <= 16, "InStates storage too small");
+	uint16_t m_bits = 0; // all unknown
+};
+
 struct RcsInputModule {
 	unsigned addr;
 	QString name;
 	bool wantActive = false;
 	bool realActive = false;
-	std::array<unsigned, IO_IN_MODULE_PIN_COUNT> inputFallDelays; // [0.1s]: 10=1.0s, 5=0.5 s
-	std::array<XnInState, IO_IN_MODULE_PIN_COUNT> state;
-	QTimer inputFallTimers[IO_IN_MODULE_PIN_COUNT];
-
-	RcsInputModule();
+	std::array<uint8_t, IO_IN_MODULE_PIN_COUNT> inputFallDelays; // [0.1s]: 10=1.0s, 5=0.5 s
+	InStates state;
 
-	void load(const QSettings&, unsigned addr);
+	void load(const IniSection&, unsigned addr);
 	void save(QSettings&) const;
 	static QString fallDelayToStr(unsigned fallDelay);
 	bool allDefaults() const;
 	QString defaultName() const;
-	void stopAllFallTimers();
 };
 
 } // namespace RcsXn
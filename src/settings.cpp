@@ -9,20 +9,18 @@ void Settings::loadDefaults() {
 				data[gm.first][k.first] = k.second;
 }
 
-void Settings::load(QSettings &s, bool loadNonDefaults) {
+void Settings::load(const RcsXn::IniData &s, bool loadNonDefaults) {
 	data.clear();
 
-	for (const auto &g : s.childGroups()) {
-		if ((!loadNonDefaults) && (DEFAULTS.find(g) == DEFAULTS.end()))
+	for (const auto &g : s.sections) {
+		if ((!loadNonDefaults) && (DEFAULTS.find(g.first) == DEFAULTS.end()))
 			continue;
 
-		s.beginGroup(g);
-		for (const auto &k : s.childKeys()) {
-			if ((!loadNonDefaults) && (DEFAULTS.at(g).find(k) == DEFAULTS.at(g).end()))
+		for (const auto &k : g.second.values) {
+			if ((!loadNonDefaults) && (DEFAULTS.at(g.first).find(k.first) == DEFAULTS.at(g.first).end()))
 				continue;
-			data[g][k] = s.value(k, "");
+			data[g.first][k.first] = k.second;
 		}
-		s.endGroup();
 	}
 
 	this->loadDefaults();
@@ -5,6 +5,8 @@
 #include <QString>
 #include <map>
 
+#include "ini-data.h"
+
 /* This file defines global settings of the application */
 
 using Config = std::map<QString, std::map<QString, QVariant>>;
@@ -17,12 +19,16 @@ const Config DEFAULTS {
 		{"loglevel", 1},
 		{"interface", "LI101"},
 		{"outIntervalMs", 50},
+		{"scanWindow", 0}, // 0 = default for interface type
+		{"outputCoalesceMs", 100}, // 0 = disabled
 	}},
 	{"global", {
 		{"addrRange", "basic"},
 		{"resetSignals", false},
 		{"mockInputs", false},
 		{"disableSetOutputOff", false},
+		{"warmRestart", false}, // serve I/O state from snapshot while scanning after start
+		{"warmRestartMaxAge", 300}, // s; older snapshot is not used, 0 = no limit
 	}},
 	{"modules", {
 		{"active-in", ""}, // unused, backward compatibility only
@@ -36,7 +42,7 @@ public:
 	Settings();
 	Config data;
 
-	void load(QSettings& s, bool loadNonDefaults = true);
+	void load(const RcsXn::IniData& s, bool loadNonDefaults = true);
 	void save(QSettings& s);
 
 	std::map<QString, QVariant> &at(const QString &g);
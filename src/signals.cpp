@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <utility>
+
 #include "signals.h"
 #include "lib/q-str-exception.h"
 
@@ -5,15 +8,14 @@ namespace RcsXn {
 
 XnSignalTemplate::XnSignalTemplate() = default;
 
-XnSignalTemplate::XnSignalTemplate(QSettings &s) { this->loadData(s); }
+XnSignalTemplate::XnSignalTemplate(const IniSection &s) { this->loadData(s); }
 
-void XnSignalTemplate::loadData(QSettings &s) {
-	// expects already beginned group
-	for (const auto &k : s.childKeys()) {
+void XnSignalTemplate::loadData(const IniSection &s) {
+	for (const auto &value : s.values) {
 		try {
 			bool isNum = false;
-			unsigned int scomCode = k.toUInt(&isNum);
-			const QString output = s.value(k, "00").toString();
+			unsigned int scomCode = value.first.toUInt(&isNum);
+			const QString &output = value.second;
 			if (isNum && isValidSignalOutputStr(output)) {
 				this->outputs[scomCode] = output;
 				this->outputsCount = static_cast<std::size_t>(output.length());
@@ -31,14 +33,20 @@ void XnSignalTemplate::saveData(QSettings &s) const {
 
 XnSignal::XnSignal() = default;
 
-XnSignal::XnSignal(QSettings &s, unsigned int hJOPaddr) : hJOPaddr(hJOPaddr) { this->loadData(s); }
+XnSignal::XnSignal(const IniSection &s, unsigned int hJOPaddr) : hJOPaddr(hJOPaddr) {
+	this->loadData(s);
+}
 
-void XnSignal::loadData(QSettings &s) {
+void XnSignal::loadData(const IniSection &s) {
 	tmpl.loadData(s);
 	this->startAddr = s.value("startAddr", this->hJOPaddr).toUInt();
 	this->name = s.value("name", QString::number(this->hJOPaddr)).toString();
 }
 
+void XnSignal::compile(SigTemplateCache &cache) {
+	this->compiled = cache.compile(this->tmpl);
+}
+
 void XnSignal::saveData(QSettings &s) const {
 	tmpl.saveData(s);
 	if (this->startAddr != this->hJOPaddr)
@@ -60,6 +68,76 @@ QString XnSignal::outputRange() const {
 	       QString::number(this->startAddr + this->tmpl.outputsCount - 1);
 }
 
+const CompactAspect *CompiledSigTemplate::aspect(unsigned int code) const {
+	if (code < this->aspects.size())
+		return (this->aspects[code].defined) ? &this->aspects[code] : nullptr;
+	const auto it = this->otherAspects.find(code);
+	return (it != this->otherAspects.end()) ? &it->second : nullptr;
+}
+
+static CompactAspect compileAspect(const QString &outputs, std::size_t outputsCount) {
+	CompactAspect aspect;
+	aspect.defined = true;
+
+	const std::size_t count = std::min(outputsCount, static_cast<std::size_t>(outputs.length()));
+	aspect.outputs.resize(count);
+	for (std::size_t i = 0; i < count; i++) {
+		const QChar state = outputs[static_cast<int>(i)];
+		aspect.outputs[i] = state.toLatin1();
+
+		const uint16_t minus = static_cast<uint16_t>(2*i);
+		const uint16_t plus = static_cast<uint16_t>(2*i + 1);
+
+		if (state == '+') {
+			aspect.cmds.push_back({plus, true});
+		} else if (state == '-') {
+			aspect.cmds.push_back({minus, true});
+		} else if (state == '0') {
+			aspect.cmds.push_back({minus, false});
+			aspect.cmds.push_back({plus, false});
+		} else if (state == '1') {
+			aspect.cmds.push_back({minus, true});
+			aspect.cmds.push_back({plus, true});
+		}
+	}
+
+	return aspect;
+}
+
+std::shared_ptr<const CompiledSigTemplate> SigTemplateCache::compile(const XnSignalTemplate &tmpl) {
+	QString key = QString::number(tmpl.outputsCount);
+	for (const std::pair<const unsigned int, QString> &output : tmpl.outputs)
+		key += ";" + QString::number(output.first) + "=" + output.second;
+
+	const auto cached = this->m_cache.find(key);
+	if (cached != this->m_cache.end()) {
+		std::shared_ptr<const CompiledSigTemplate> compiled = cached->second.lock();
+		if (compiled != nullptr)
+			return compiled;
+	}
+
+	auto compiled = std::make_shared<CompiledSigTemplate>();
+	for (const std::pair<const unsigned int, QString> &output : tmpl.outputs) {
+		if (output.first < compiled->aspects.size())
+			compiled->aspects[output.first] = compileAspect(output.second, tmpl.outputsCount);
+		else
+			compiled->otherAspects[output.first] = compileAspect(output.second, tmpl.outputsCount);
+	}
+
+	this->prune();
+	this->m_cache[key] = compiled;
+	return compiled;
+}
+
+void SigTemplateCache::prune() {
+	for (auto it = this->m_cache.begin(); it != this->m_cache.end();) {
+		if (it->second.expired())
+			it = this->m_cache.erase(it);
+		else
+			++it;
+	}
+}
+
 bool isValidSignalOutputStr(const QString &str) {
 	const QString ALLOWED_CHARS = "01+-N";
 	for (const QChar &c : str)
@@ -68,10 +146,11 @@ bool isValidSignalOutputStr(const QString &str) {
 	return true;
 }
 
-SigStorage signalsFromFile(QSettings &s) {
+SigStorage signalsFromFile(const IniData &s, SigTemplateCache &cache) {
 	SigStorage result;
 
-	for (const auto &g : s.childGroups()) {
+	for (const auto &section : s.sections) {
+		const QString &g = section.first;
 		if (not g.startsWith("Signal"))
 			continue;
 
@@ -82,19 +161,20 @@ SigStorage signalsFromFile(QSettings &s) {
 
 			unsigned int hJOPoutput = name[1].toUInt(); // signal always at nibble 0
 
-			s.beginGroup(g);
-			result.emplace(hJOPoutput, XnSignal(s, hJOPoutput));
-			s.endGroup();
+			XnSignal signal(section.second, hJOPoutput);
+			signal.compile(cache);
+			result.emplace(hJOPoutput, std::move(signal));
 		} catch (...) { throw QStrException("Invalid signal: " + g); }
 	}
 
 	return result;
 }
 
-SigTmplStorage signalTemplatesFromFile(QSettings &s) {
+SigTmplStorage signalTemplatesFromFile(const IniData &s) {
 	SigTmplStorage result;
 
-	for (const auto &g : s.childGroups()) {
+	for (const auto &section : s.sections) {
+		const QString &g = section.first;
 		if (not g.startsWith("SigTemplate"))
 			continue;
 
@@ -105,9 +185,7 @@ SigTmplStorage signalTemplatesFromFile(QSettings &s) {
 
 			const QString sigName = name[1];
 
-			s.beginGroup(g);
-			result.emplace(sigName, XnSignalTemplate(s));
-			s.endGroup();
+			result.emplace(sigName, XnSignalTemplate(section.second));
 		} catch (...) { throw QStrException("Invalid signal template: " + g); }
 	}
 	return result;
@@ -5,7 +5,12 @@
 #include <QString>
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <array>
+#include <cstdint>
+#include <vector>
+
+#include "ini-data.h"
 
 namespace RcsXn {
 
@@ -14,26 +19,71 @@ struct XnSignalTemplate {
 	std::map<unsigned int, QString> outputs; // scom code -> outputs state
 
 	XnSignalTemplate();
-	XnSignalTemplate(QSettings &);
-	void loadData(QSettings &);
+	XnSignalTemplate(const IniSection &);
+	void loadData(const IniSection &);
 	void saveData(QSettings &) const;
+
+	bool operator==(const XnSignalTemplate &other) const {
+		return (this->outputsCount == other.outputsCount) && (this->outputs == other.outputs);
+	}
+	bool operator!=(const XnSignalTemplate &other) const { return !(*this == other); }
+};
+
+constexpr std::size_t XN_SIGNAL_CODES_COUNT = 17;
+
+/* Signal template compiled into per-aspect lists of plain output commands.
+ * Compiled templates are immutable and shared among all signals with the same
+ * template, setting an aspect is just a table lookup.
+ */
+
+struct AspectCmd {
+	uint16_t portOffset; // relative to first port of signal (2*startAddr)
+	bool state;
+};
+
+struct CompactAspect {
+	bool defined = false;
+	std::vector<AspectCmd> cmds; // commands of single output are adjacent
+	std::vector<char> outputs; // state of each output: '+', '-', '0', '1', 'N'
+};
+
+struct CompiledSigTemplate {
+	std::array<CompactAspect, XN_SIGNAL_CODES_COUNT> aspects;
+	std::map<unsigned int, CompactAspect> otherAspects; // codes >= XN_SIGNAL_CODES_COUNT
+
+	const CompactAspect *aspect(unsigned int code) const; // nullptr = code not defined
+};
+
+// Identical templates share single compiled template; entries of unused templates are pruned
+class SigTemplateCache {
+public:
+	std::shared_ptr<const CompiledSigTemplate> compile(const XnSignalTemplate &);
+
+private:
+	std::map<QString, std::weak_ptr<const CompiledSigTemplate>> m_cache;
+
+	void prune(); // removes entries of templates no signal uses anymore
 };
 
 struct XnSignal {
 	QString name;
 	unsigned int startAddr; // 0-1023
 	XnSignalTemplate tmpl;
+	std::shared_ptr<const CompiledSigTemplate> compiled; // compiled tmpl
+	std::vector<char> outputsState; // last commanded state of each output, 0 = unknown
 	unsigned int hJOPaddr;
 	unsigned int currentCode;
+	bool setByHost = false; // currentCode set by hJOP in this session (not restored from snapshot)
 
 	XnSignal();
-	XnSignal(QSettings &, unsigned int hJOPaddr);
-	void loadData(QSettings &);
+	XnSignal(const IniSection &, unsigned int hJOPaddr);
+	void loadData(const IniSection &);
 	void saveData(QSettings &) const;
+	void compile(SigTemplateCache &);
 	QString outputRange() const;
 };
 
-const std::array<QString, 17> XnSignalCodes {
+const std::array<QString, XN_SIGNAL_CODES_COUNT> XnSignalCodes {
 	"Stůj/posun zakázán",
 	"Volno",
 	"Výstraha",
@@ -57,8 +107,8 @@ using SigTmplStorage = std::map<QString, XnSignalTemplate>;
 using SigStorage = std::map<unsigned int, XnSignal>; // hJOP output -> signal mapping
 
 bool isValidSignalOutputStr(const QString &str);
-SigStorage signalsFromFile(QSettings &);
-SigTmplStorage signalTemplatesFromFile(QSettings &);
+SigStorage signalsFromFile(const IniData &, SigTemplateCache &);
+SigTmplStorage signalTemplatesFromFile(const IniData &);
 void signalsToFile(QSettings &s, const SigStorage &storage);
 void signalTmplsToFile(QSettings &s, const SigTmplStorage &storage);
 
@@ -0,0 +1,116 @@
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include "lib/q-str-exception.h"
+#include "snapshot.h"
+
+namespace RcsXn {
+
+constexpr quint32 IoSnapshot::MAGIC;
+constexpr quint16 IoSnapshot::VERSION;
+
+static quint16 checksum(const QByteArray &data) {
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	return qChecksum(data.constData(), static_cast<uint>(data.size()));
+#else
+	return qChecksum(data);
+#endif
+}
+
+template <std::size_t N>
+static void writeBits(QDataStream &ds, const BitArray<N> &bits) {
+	for (std::size_t i = 0; i < BitArray<N>::WORDS; i++)
+		ds << static_cast<quint64>(bits.word(i));
+}
+
+template <std::size_t N>
+static void readBits(QDataStream &ds, BitArray<N> &bits) {
+	for (std::size_t i = 0; i < BitArray<N>::WORDS; i++) {
+		quint64 word;
+		ds >> word;
+		bits.setWord(i, word);
+	}
+}
+
+void IoSnapshot::save(const QString &filename) const {
+	QByteArray payload;
+	{
+		QDataStream ds(&payload, QIODevice::WriteOnly);
+		ds.setVersion(QDataStream::Qt_5_0);
+		ds << static_cast<qint64>(this->timestamp);
+		for (uint16_t state : this->inputs)
+			ds << static_cast<quint16>(state);
+		writeBits(ds, this->realActive);
+		writeBits(ds, this->outputs);
+		ds << static_cast<quint32>(this->signalCodes.size());
+		for (const auto &signal : this->signalCodes)
+			ds << static_cast<quint32>(signal.first) << static_cast<quint32>(signal.second);
+	}
+
+	QSaveFile file(filename);
+	if (!file.open(QIODevice::WriteOnly))
+		throw QStrException("Nelze otevřít soubor " + filename);
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_5_0);
+	ds << MAGIC << VERSION << payload << checksum(payload);
+	if ((ds.status() != QDataStream::Ok) || (!file.commit()))
+		throw QStrException("Nelze zapsat soubor " + filename);
+}
+
+bool IoSnapshot::load(const QString &filename, IoSnapshot &result, QString &error) {
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly)) {
+		error = "soubor nelze otevřít";
+		return false;
+	}
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_5_0);
+	quint32 magic;
+	quint16 version, crc;
+	QByteArray payload;
+	ds >> magic >> version;
+	if ((ds.status() != QDataStream::Ok) || (magic != MAGIC)) {
+		error = "neplatný formát";
+		return false;
+	}
+	if (version != VERSION) {
+		error = "nepodporovaná verze " + QString::number(version);
+		return false;
+	}
+	ds >> payload >> crc;
+	if ((ds.status() != QDataStream::Ok) || (crc != checksum(payload))) {
+		error = "nesouhlasí kontrolní součet";
+		return false;
+	}
+
+	QDataStream pds(payload);
+	pds.setVersion(QDataStream::Qt_5_0);
+	qint64 timestamp;
+	pds >> timestamp;
+	result.timestamp = timestamp;
+	for (uint16_t &state : result.inputs) {
+		quint16 raw;
+		pds >> raw;
+		state = raw;
+	}
+	readBits(pds, result.realActive);
+	readBits(pds, result.outputs);
+	quint32 count;
+	pds >> count;
+	result.signalCodes.clear();
+	for (quint32 i = 0; (i < count) && (pds.status() == QDataStream::Ok); i++) {
+		quint32 addr, code;
+		pds >> addr >> code;
+		result.signalCodes[addr] = code;
+	}
+
+	if ((pds.status() != QDataStream::Ok) || (!pds.atEnd())) {
+		error = "neplatná data";
+		return false;
+	}
+	return true;
+}
+
+} // namespace RcsXn
@@ -0,0 +1,35 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+/* Snapshot of last known I/O state for warm restart. It is stored in a small
+ * versioned binary file with checksum next to the config file. After start,
+ * states from snapshot are served as provisional until modules are scanned.
+ */
+
+#include <QString>
+#include <array>
+#include <map>
+
+#include "bit-array.h"
+#include "common.h"
+
+namespace RcsXn {
+
+struct IoSnapshot {
+	static constexpr quint32 MAGIC = 0x52585353; // "RXSS"
+	static constexpr quint16 VERSION = 1;
+
+	qint64 timestamp = 0; // ms since epoch
+	std::array<uint16_t, IO_IN_MODULES_COUNT> inputs {}; // InStates::raw of each module
+	BitArray<IO_IN_MODULES_COUNT> realActive;
+	BitArray<IO_COUNT> outputs;
+	std::map<unsigned int, unsigned int> signalCodes; // hJOP address -> code
+
+	void save(const QString &filename) const; // throws QStrException
+	// returns false (& fills error) if file is missing, invalid or of other version
+	static bool load(const QString &filename, IoSnapshot &result, QString &error);
+};
+
+} // namespace RcsXn
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,122 @@
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <exception>
+#include <new>
+
+#include "xn-thread.h"
+
+namespace RcsXn {
+
+XnThread::XnThread() {
+	if (qApp != nullptr)
+		QObject::connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() { this->shutdown(); });
+}
+
+bool XnThread::running() {
+	// Thread killed by process exit is reported as finished after wait
+	return (this->isRunning()) && (!this->wait(0));
+}
+
+void XnThread::shutdown() {
+	if ((this->isCurrent()) || (!this->running()))
+		return;
+
+	this->quit();
+	this->wait(); // run() destroys the core
+
+	// Context of host thread is destroyed unless the thread was started again in meantime
+	QMutexLocker locker(&this->m_start_lock);
+	if ((this->m_host_context == nullptr) || (this->running()))
+		return;
+	QCoreApplication::removePostedEvents(this->m_host_context);
+	if (QThread::currentThread() == this->m_host_context->thread())
+		delete this->m_host_context;
+	else
+		this->m_host_context->deleteLater();
+	this->m_host_context = nullptr;
+}
+
+void XnThread::ensureRunning() {
+	if (this->m_alive)
+		return;
+
+	QMutexLocker locker(&this->m_start_lock);
+	if ((!this->m_alive) && (!this->isRunning())) {
+		this->setObjectName("XpressNET");
+		this->start();
+		this->m_ready.acquire();
+	}
+}
+
+void XnThread::run() {
+	if (this->m_host_context == nullptr) { // created for each run, destroyed by shutdown()
+		this->m_host_context = new QObject();
+		this->m_host_context->moveToThread(this->thread()); // thread which created XnThread
+	}
+
+	RcsXn *core = new (&this->m_storage) RcsXn();
+	core->events.hostContext = this->m_host_context;
+	core->events.xnThread = this;
+	core->observer = this->m_observer;
+	core->refreshLogLevel();
+	this->m_alive = true;
+	this->m_ready.release();
+
+	this->exec();
+
+	// Host thread waits for us now -> events raised while closing are delivered directly.
+	// Deliveries posted to host thread and not performed yet refer to the core.
+	core->events.hostContext = nullptr;
+	QCoreApplication::removePostedEvents(this->m_host_context);
+	core->~RcsXn();
+	this->m_alive = false;
+}
+
+void XnThread::setObserver(RcsXnObserver *observer) {
+	QMutexLocker locker(&this->m_start_lock);
+	this->m_observer = observer;
+	if (!this->m_alive)
+		return;
+
+	if (this->running()) {
+		this->callVoid([this, observer]() {
+			this->core().observer = observer;
+			this->core().refreshLogLevel();
+		});
+	} else {
+		this->core().observer = observer;
+	}
+}
+
+void XnThread::post(std::function<void()> f) {
+	if (this->isCurrent()) {
+		f();
+		return;
+	}
+
+	this->ensureRunning();
+	QMetaObject::invokeMethod(&this->core(), std::move(f), Qt::QueuedConnection);
+}
+
+void XnThread::callVoid(const std::function<void()> &f) {
+	if (this->isCurrent()) {
+		f();
+		return;
+	}
+
+	this->ensureRunning();
+
+	std::exception_ptr error;
+	QMetaObject::invokeMethod(&this->core(), [&f, &error]() {
+		try {
+			f();
+		} catch (...) {
+			error = std::current_exception();
+		}
+	}, Qt::BlockingQueuedConnection);
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+} // namespace RcsXn
@@ -0,0 +1,80 @@
+#ifndef XN_THREAD_H
+#define XN_THREAD_H
+
+/* Dedicated thread of XpressNET connection and RcsXn core. Serial port,
+ * timers and the whole state machine run in its event loop, so GUI or slow
+ * host callbacks do not delay processing of XpressNET data. RcsXn is
+ * constructed and destroyed in this thread.
+ *
+ * The thread is started lazily on first call(), not during library loading
+ * (waiting for a new thread in static initialization of DLL would deadlock).
+ * For the same reason it is never joined in a static destructor (DLL unloading
+ * holds the loader lock): the host stops it by Shutdown() before FreeLibrary,
+ * QCoreApplication::aboutToQuit stops it in applications owning the event
+ * loop. XnThread object itself is never destroyed.
+ *
+ * Other threads (host API calls, GUI) access the core only via call(), which
+ * runs the function in XN thread and waits for its result. Exceptions are
+ * rethrown in caller's thread. Calls from XN thread itself (e.g. host
+ * callback delivered directly) are executed immediately. post() queues the
+ * function without waiting (writes validated against published state);
+ * posted & called functions of one thread run in order they were issued.
+ */
+
+#include <QMutex>
+#include <QObject>
+#include <QSemaphore>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+#include "rcs-xn.h"
+
+namespace RcsXn {
+
+class XnThread : public QThread {
+public:
+	XnThread();
+
+	// Storage of the core; object exists only after first call()
+	RcsXn &core() { return *reinterpret_cast<RcsXn *>(&this->m_storage); }
+	bool isCurrent() const { return QThread::currentThread() == this; }
+	bool alive() const { return this->m_alive; } // core could be read
+	void setObserver(RcsXnObserver *observer); // could be called before the thread starts
+	void shutdown(); // destroys the core & joins the thread; next call() starts it again
+
+	template <typename F>
+	auto call(F &&f) -> typename std::enable_if<
+		!std::is_void<decltype(f())>::value, typename std::decay<decltype(f())>::type>::type {
+		typename std::decay<decltype(f())>::type result {};
+		this->callVoid([&result, &f]() { result = f(); });
+		return result;
+	}
+
+	template <typename F>
+	auto call(F &&f) -> typename std::enable_if<std::is_void<decltype(f())>::value>::type {
+		this->callVoid(f);
+	}
+
+	void post(std::function<void()> f); // f must not throw
+
+protected:
+	void run() override;
+
+private:
+	typename std::aligned_storage<sizeof(RcsXn), alignof(RcsXn)>::type m_storage;
+	std::atomic<bool> m_alive {false}; // core constructed & not destroyed
+	QMutex m_start_lock;
+	QSemaphore m_ready;
+	QObject *m_host_context = nullptr; // receives events posted to host thread, see run()
+	RcsXnObserver *m_observer = nullptr;
+
+	bool running(); // isRunning() is stale for thread killed at process exit
+	void ensureRunning();
+	void callVoid(const std::function<void()> &f);
+};
+
+} // namespace RcsXn
+
+#endif // XN_THREAD_H
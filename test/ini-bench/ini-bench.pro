@@ -0,0 +1,20 @@
+# Benchmark of config loading: single-pass IniData reader against the original
+# QSettings group walks, on a synthetic config with 2048 inputs & 2048 outputs.
+# Usage: ini-bench [rounds] [config-file]
+# Config file is generated when it does not exist (or a temporary one is used).
+
+TARGET = ini-bench
+TEMPLATE = app
+
+CONFIG += console c++14 testcase # make check runs 50 rounds on generated config
+CONFIG -= app_bundle
+QT -= gui
+QMAKE_CXXFLAGS += -Wall -Wextra -pedantic
+
+INCLUDEPATH += ../.. ../../src
+
+SOURCES += \
+	main.cpp \
+	../../src/ini-data.cpp
+HEADERS += \
+	../../src/ini-data.h
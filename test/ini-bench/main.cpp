@@ -0,0 +1,250 @@
+/* Benchmark of config loading on a synthetic config with 2048 inputs
+ * (256 input modules with names & fall delays) and 2048 outputs (1024 active
+ * output modules, 256 signals of 16 templates).
+ *
+ * Both paths read the same values the library reads on LoadConfig:
+ *  - original: QSettings with childGroups walks for settings, signals and
+ *    templates and beginGroup for each of 256 input modules,
+ *  - IniData: single pass over the file, sections looked up by name.
+ * Each round reads a fresh copy of the file, because QSettings caches parsed
+ * files by name and the library loads the config once per process.
+ *
+ * IniData::fromFile is also checked to give the same data as reading the
+ * file by QSettings (IniData::fromSettings).
+ */
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+
+#include "ini-data.h"
+
+using namespace RcsXn;
+
+constexpr unsigned IN_MODULES = 256;
+constexpr unsigned OUT_MODULES = 1024;
+constexpr unsigned SIGNALS = 256;
+constexpr unsigned TEMPLATES = 16;
+constexpr unsigned PIN_COUNT = 8;
+
+static const std::set<QString> SETTINGS_GROUPS {"XN", "global", "modules"};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void generateConfig(const QString &filename) {
+	QSettings s(filename, QSettings::IniFormat);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	s.setIniCodec("UTF-8");
+#endif
+	s.clear();
+
+	s.setValue("XN/port", "COM3");
+	s.setValue("XN/baudrate", 19200);
+	s.setValue("XN/interface", "LI-USB-Ethernet");
+	s.setValue("XN/loglevel", 3);
+	s.setValue("global/addrRange", "basic");
+	s.setValue("global/resetSignals", true);
+	s.setValue("global/warmRestart", true);
+	s.setValue("modules/active-out", "0-" + QString::number(OUT_MODULES-1));
+	s.setValue("modules/binary", "900-1023");
+
+	static const char *outputs[] = {"+-00", "-+00", "--+0", "+-+0", "0011", "1100"};
+	for (unsigned t = 0; t < TEMPLATES; t++) {
+		s.beginGroup("SigTemplate-Návěstidlo " + QString::number(t));
+		for (unsigned code = 0; code < 6; code++)
+			s.setValue(QString::number(code+t%3), outputs[code]);
+		s.endGroup();
+	}
+
+	for (unsigned i = 0; i < SIGNALS; i++) {
+		s.beginGroup("Signal-" + QString::number(4*i));
+		for (unsigned code = 0; code < 6; code++)
+			s.setValue(QString::number(code+i%3), outputs[(code+i)%6]);
+		s.setValue("startAddr", 4*i + 1);
+		s.setValue("name", "Se" + QString::number(i) + " (žst. " + QString::number(i/16) + ")");
+		s.endGroup();
+	}
+
+	for (unsigned i = 0; i < IN_MODULES; i++) {
+		s.beginGroup("InModule-" + QString::number(i));
+		s.setValue("name", "Modul " + QString::number(i) + ", úsek " + QString::number(i/8));
+		s.setValue("active", true);
+		for (unsigned port = 0; port < PIN_COUNT; port++)
+			s.setValue("fallDelay" + QString::number(port+1), QString::number(port%3) + ".5");
+		s.endGroup();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Original loading (values are only counted)
+
+static size_t loadQSettings(const QString &filename) {
+	QSettings s(filename, QSettings::IniFormat);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	s.setIniCodec("UTF-8");
+#endif
+	size_t values = 0;
+
+	// Settings::load
+	for (const QString &g : s.childGroups()) {
+		if (SETTINGS_GROUPS.find(g) == SETTINGS_GROUPS.end())
+			continue;
+		s.beginGroup(g);
+		for (const QString &k : s.childKeys())
+			values += !s.value(k, "").toString().isEmpty();
+		s.endGroup();
+	}
+
+	// signalsFromFile & signalTemplatesFromFile
+	for (const QString &g : s.childGroups()) {
+		if (!g.startsWith("Signal"))
+			continue;
+		s.beginGroup(g);
+		for (const QString &k : s.childKeys())
+			values += !s.value(k, "00").toString().isEmpty();
+		values += (s.value("startAddr", 0).toUInt() > 0);
+		values += !s.value("name", "").toString().isEmpty();
+		s.endGroup();
+	}
+	for (const QString &g : s.childGroups()) {
+		if (!g.startsWith("SigTemplate"))
+			continue;
+		s.beginGroup(g);
+		for (const QString &k : s.childKeys())
+			values += !s.value(k, "00").toString().isEmpty();
+		s.endGroup();
+	}
+
+	// loadInputModules
+	for (unsigned i = 0; i < IN_MODULES; i++) {
+		s.beginGroup("InModule-" + QString::number(i));
+		values += !s.value("name", "").toString().isEmpty();
+		values += s.value("active", false).toBool();
+		for (unsigned port = 0; port < PIN_COUNT; port++)
+			values += !s.value("fallDelay" + QString::number(port+1), "").toString().isEmpty();
+		s.endGroup();
+	}
+
+	return values;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Single-pass loading
+
+static size_t loadIniData(const QString &filename) {
+	std::vector<IniError> errors;
+	const IniData data = IniData::fromFile(filename, errors);
+	if (!errors.empty())
+		return 0;
+	size_t values = 0;
+
+	for (const auto &section : data.sections) {
+		const QString &g = section.first;
+		if (SETTINGS_GROUPS.find(g) != SETTINGS_GROUPS.end()) {
+			for (const auto &value : section.second.values)
+				values += !value.second.isEmpty();
+		} else if (g.startsWith("Signal")) {
+			for (const auto &value : section.second.values)
+				values += !value.second.isEmpty();
+			values += (section.second.value("startAddr", 0).toUInt() > 0);
+			values += !section.second.value("name", "").toString().isEmpty();
+		} else if (g.startsWith("SigTemplate")) {
+			for (const auto &value : section.second.values)
+				values += !value.second.isEmpty();
+		}
+	}
+
+	for (unsigned i = 0; i < IN_MODULES; i++) {
+		const IniSection &s = data.section("InModule-" + QString::number(i));
+		values += !s.value("name", "").toString().isEmpty();
+		values += s.value("active", false).toBool();
+		for (unsigned port = 0; port < PIN_COUNT; port++)
+			values += !s.value("fallDelay" + QString::number(port+1), "").toString().isEmpty();
+	}
+
+	return values;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool sameAsQSettings(const QString &filename, QTextStream &out) {
+	std::vector<IniError> errors;
+	const IniData data = IniData::fromFile(filename, errors);
+	for (const IniError &error : errors)
+		out << filename << ":" << error.line << ": " << error.message << "\n";
+
+	QSettings s(filename, QSettings::IniFormat);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	s.setIniCodec("UTF-8");
+#endif
+	const IniData reference = IniData::fromSettings(s);
+
+	// Empty sections are not compared (IniData always has "General")
+	bool same = errors.empty();
+	for (const IniData *a : {&data, &reference}) {
+		const IniData *b = (a == &data) ? &reference : &data;
+		for (const auto &section : a->sections) {
+			if ((!section.second.values.empty()) &&
+			    (b->section(section.first).values != section.second.values)) {
+				out << "section differs: " << section.first << "\n";
+				same = false;
+			}
+		}
+	}
+	return same;
+}
+
+int main(int argc, char *argv[]) {
+	QTextStream out(stdout);
+	const unsigned rounds = (argc > 1) ? static_cast<unsigned>(std::max(1, std::atoi(argv[1])))
+	                                   : 50;
+
+	QTemporaryDir tmp;
+	if (!tmp.isValid()) {
+		out << "Cannot create temporary directory\n";
+		return EXIT_FAILURE;
+	}
+	const QString config = (argc > 2) ? QString::fromLocal8Bit(argv[2])
+	                                  : tmp.filePath("config.ini");
+	if (!QFile::exists(config))
+		generateConfig(config);
+
+	if (!sameAsQSettings(config, out)) {
+		out << "IniData does not match QSettings\n";
+		return EXIT_FAILURE;
+	}
+
+	QStringList copies;
+	for (unsigned i = 0; i < 2*rounds; i++) {
+		copies.append(tmp.filePath("copy-" + QString::number(i) + ".ini"));
+		QFile::copy(config, copies.back());
+	}
+
+	QElapsedTimer timer;
+	size_t valuesQSettings = 0, valuesIniData = 0;
+	qint64 tQSettings = 0, tIniData = 0;
+	for (unsigned i = 0; i < rounds; i++) {
+		timer.start();
+		valuesQSettings = loadQSettings(copies[static_cast<int>(2*i)]);
+		tQSettings += timer.nsecsElapsed();
+
+		timer.start();
+		valuesIniData = loadIniData(copies[static_cast<int>(2*i+1)]);
+		tIniData += timer.nsecsElapsed();
+	}
+
+	out << QFileInfo(config).size() << " B config, " << rounds << " rounds, ms/load:\n";
+	out << "  QSettings: " << tQSettings/rounds/1e6 << " (" << valuesQSettings << " values)\n";
+	out << "  IniData:   " << tIniData/rounds/1e6 << " (" << valuesIniData << " values)\n";
+	if ((rounds > 0) && (tIniData > 0))
+		out << "  speedup:   " << static_cast<double>(tQSettings)/tIniData << "x\n";
+
+	return (valuesQSettings == valuesIniData) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
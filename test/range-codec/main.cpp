@@ -0,0 +1,206 @@
+/* Differential fuzzer & benchmark of RangeCodec (src/range-codec.h) against
+ * the original implementation of RcsXn::parseModules & getActiveStr.
+ *
+ * Random range lists are parsed by both implementations; resulting bit arrays
+ * and number of invalid tokens must match unless the string contains a token
+ * RangeCodec handles differently on purpose:
+ *  - reversed range ("5-3") is invalid (original silently ignored it),
+ *  - whitespace-only token is skipped (original reported it),
+ *  - sign ("+5") is invalid (original accepted it by QString::toUInt),
+ *  - number with more than 9 digits is invalid (even "0000000001").
+ * Random bit arrays are serialized by both implementations (strings must be
+ * equal) and parsed back (round-trip must be lossless).
+ */
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <cstdlib>
+#include <random>
+
+#include "bit-array.h"
+#include "range-codec.h"
+
+using namespace RcsXn;
+
+constexpr std::size_t N = 1024; // output modules
+
+///////////////////////////////////////////////////////////////////////////////
+// Original implementation (exceptions & logs replaced by counting)
+
+template <std::size_t ArraySize>
+static unsigned refParse(const QString &active, BitArray<ArraySize> &result) {
+	unsigned errors = 0;
+	result.reset();
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	const QStringList ranges = active.split(',', QString::SkipEmptyParts);
+#else
+	const QStringList ranges = active.split(',', Qt::SkipEmptyParts);
+#endif
+
+	for (const QString &range : ranges) {
+		const QStringList bounds = range.split('-');
+		bool okl, okr = false;
+		if (bounds.size() == 1) {
+			unsigned int addr = bounds[0].toUInt(&okl);
+			if ((okl) && (addr < result.size()))
+				result.set(addr);
+			else
+				errors++;
+		} else if (bounds.size() == 2) {
+			unsigned int left = bounds[0].toUInt(&okl);
+			unsigned int right = bounds[1].toUInt(&okr);
+			if ((okl) & (okr) && (left < result.size()) && (right < result.size())) {
+				if (left <= right)
+					result.setRange(left, right);
+			} else {
+				errors++;
+			}
+		} else {
+			errors++;
+		}
+	}
+	return errors;
+}
+
+template <std::size_t ArraySize>
+static QString refSerialize(const BitArray<ArraySize> &source, const QString &separator) {
+	QString output;
+	size_t start = source.findNext(true, 0);
+	while (start < source.size()) {
+		const size_t end = source.findNext(false, start);
+		if (end == start+1)
+			output += QString::number(start)+separator;
+		else
+			output += QString::number(start)+"-"+QString::number(end-1)+separator;
+		start = source.findNext(true, end);
+	}
+	return output;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool knownDeviation(const QString &str) {
+	for (const QString &token : str.split(',')) {
+		if ((!token.isEmpty()) && (token.trimmed().isEmpty()))
+			return true;
+		if (token.contains('+'))
+			return true;
+		const QStringList bounds = token.split('-');
+		for (const QString &bound : bounds)
+			if (bound.trimmed().size() > 9)
+				return true;
+		bool okl, okr;
+		if ((bounds.size() == 2) && (bounds[0].toUInt(&okl) > bounds[1].toUInt(&okr)) && okl && okr)
+			return true;
+	}
+	return false;
+}
+
+template <std::size_t ArraySize>
+static bool equal(const BitArray<ArraySize> &a, const BitArray<ArraySize> &b) {
+	for (std::size_t i = 0; i < BitArray<ArraySize>::WORDS; i++)
+		if (a.word(i) != b.word(i))
+			return false;
+	return true;
+}
+
+static QString randomRanges(std::mt19937 &rng) {
+	static const char alphabet[] = "0123456789012345678901234567890123456789,,,,---- +x";
+	std::uniform_int_distribution<int> length(0, 40);
+	std::uniform_int_distribution<int> chr(0, sizeof(alphabet) - 2);
+	QString result;
+	const int len = length(rng);
+	for (int i = 0; i < len; i++)
+		result += QLatin1Char(alphabet[chr(rng)]);
+	return result;
+}
+
+static void randomBits(std::mt19937 &rng, BitArray<N> &bits) {
+	std::uniform_int_distribution<std::size_t> run(1, 40);
+	std::bernoulli_distribution on(0.5);
+	bits.reset();
+	std::size_t i = 0;
+	while (i < N) {
+		const std::size_t end = std::min(N, i + run(rng));
+		if (on(rng))
+			bits.setRange(i, end-1);
+		i = end;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	QTextStream out(stdout);
+	const unsigned iterations = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : 100000;
+	const unsigned seed = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 1;
+	std::mt19937 rng(seed);
+	unsigned failures = 0;
+
+	// Parser
+	for (unsigned i = 0; i < iterations; i++) {
+		const QString str = randomRanges(rng);
+		BitArray<N> ref, res;
+		const unsigned refErrors = refParse(str, ref);
+		const std::vector<RangeError> errors = RangeCodec::parse(QStringView(str), res);
+		if (((!equal(ref, res)) || (refErrors != errors.size())) && (!knownDeviation(str))) {
+			out << "parse mismatch: \"" << str << "\"\n";
+			failures++;
+		}
+		for (const RangeError &error : errors) {
+			if (!str.mid(static_cast<int>(error.position)).trimmed().startsWith(error.token)) {
+				out << "bad error position: \"" << str << "\" " << error.position << "\n";
+				failures++;
+			}
+		}
+	}
+
+	// Serializer
+	for (unsigned i = 0; i < iterations; i++) {
+		BitArray<N> bits, parsed;
+		randomBits(rng, bits);
+		const QString str = RangeCodec::serialize(bits, ",");
+		if (str != refSerialize(bits, ",")) {
+			out << "serialize mismatch: \"" << str << "\"\n";
+			failures++;
+		}
+		if ((!RangeCodec::parse(QStringView(str), parsed).empty()) || (!equal(bits, parsed))) {
+			out << "round-trip failed: \"" << str << "\"\n";
+			failures++;
+		}
+	}
+
+	// Benchmark on typical config ("1-28,70-92" style, ~100 runs)
+	BitArray<N> bits, parsed;
+	randomBits(rng, bits);
+	const QString str = RangeCodec::serialize(bits, ",");
+	constexpr unsigned BENCH_ROUNDS = 10000;
+	QElapsedTimer timer;
+	qint64 t[4];
+
+	timer.start();
+	for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+		refParse(str, parsed);
+	t[0] = timer.nsecsElapsed();
+	timer.restart();
+	for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+		RangeCodec::parse(QStringView(str), parsed);
+	t[1] = timer.nsecsElapsed();
+	timer.restart();
+	for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+		refSerialize(bits, ",");
+	t[2] = timer.nsecsElapsed();
+	timer.restart();
+	for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+		RangeCodec::serialize(bits, ",");
+	t[3] = timer.nsecsElapsed();
+
+	out << "string of " << str.size() << " chars, " << BENCH_ROUNDS << " rounds, us/op:\n";
+	out << "  parse:     original " << t[0]/BENCH_ROUNDS/1000.0 << ", RangeCodec "
+	    << t[1]/BENCH_ROUNDS/1000.0 << "\n";
+	out << "  serialize: original " << t[2]/BENCH_ROUNDS/1000.0 << ", RangeCodec "
+	    << t[3]/BENCH_ROUNDS/1000.0 << "\n";
+	out << failures << " failures in " << iterations << " iterations (seed " << seed << ")\n";
+	return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
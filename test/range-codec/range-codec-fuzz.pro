@@ -0,0 +1,18 @@
+# Differential fuzzer & benchmark of RangeCodec against the original
+# QStringList-based parseModules/getActiveStr.
+# Usage: range-codec-fuzz [iterations] [seed]
+
+TARGET = range-codec-fuzz
+TEMPLATE = app
+
+CONFIG += console c++14 testcase # make check runs default 100000 iterations, seed 1
+CONFIG -= app_bundle
+QT -= gui
+QMAKE_CXXFLAGS += -Wall -Wextra -pedantic
+
+INCLUDEPATH += ../../src
+
+SOURCES += main.cpp
+HEADERS += \
+	../../src/bit-array.h \
+	../../src/range-codec.h
@@ -0,0 +1,9 @@
+# Test harnesses (not part of the library build). `make check` builds & runs all of them;
+# each exits with non-zero code on failure.
+
+TEMPLATE = subdirs
+
+SUBDIRS += range-codec
+range-codec.file = range-codec/range-codec-fuzz.pro
+
+SUBDIRS += ini-bench